@@ -29,12 +29,15 @@
 #include "Font.h"
 #include "LineEdit.h"
 #include "ListView.h"
+#include "Log.h"
+#include "Script.h"
 #include "ScrollBar.h"
 #include "Slider.h"
 #include "Sprite.h"
 #include "Text.h"
 #include "Text3D.h"
 #include "UI.h"
+#include "UIAnimator.h"
 #include "Window.h"
 #include "View3D.h"
 
@@ -46,6 +49,75 @@ static void RegisterFont(asIScriptEngine* engine)
     RegisterResource<Font>(engine, "Font");
 }
 
+/// %UI event delegate that calls a script function.
+class ScriptUIEventDelegate : public UIEventDelegate
+{
+public:
+    /// Construct. Takes over the reference to the function.
+    ScriptUIEventDelegate(asIScriptFunction* function) :
+        function_(function),
+        script_(GetScriptContext()->GetSubsystem<Script>())
+    {
+    }
+
+    /// Destruct. Release the function.
+    virtual ~ScriptUIEventDelegate()
+    {
+        function_->Release();
+    }
+
+    /// Call the script function.
+    virtual void Invoke(UIElement* element, int x, int y)
+    {
+        if (!script_)
+            return;
+
+        // Use the script subsystem's context for the current nesting level, as the delegate may be invoked while another script
+        // function is executing. The contexts are reused, so no context is created per click
+        asIScriptContext* context = script_->GetScriptFileContext();
+        if (context->Prepare(function_) < 0)
+            return;
+
+        context->SetArgObject(0, element);
+        context->SetArgDWord(1, x);
+        context->SetArgDWord(2, y);
+
+        script_->IncScriptNestingLevel();
+        if (context->Execute() == asEXECUTION_EXCEPTION)
+            LOGERROR("Exception in UI delegate " + String(function_->GetDeclaration()) + ": " + String(context->GetExceptionString()));
+        context->Unprepare();
+        script_->DecScriptNestingLevel();
+    }
+
+private:
+    /// Script function.
+    asIScriptFunction* function_;
+    /// Script subsystem.
+    WeakPtr<Script> script_;
+};
+
+static UI* GetUI()
+{
+    return GetScriptContext()->GetSubsystem<UI>();
+}
+
+static void UIElementSetOnClick(asIScriptFunction* function, UIElement* ptr)
+{
+    GetUI()->SetClickDelegate(ptr, function ? new ScriptUIEventDelegate(function) : 0);
+}
+
+static void UIElementSetOnClickEnd(asIScriptFunction* function, UIElement* ptr)
+{
+    GetUI()->SetClickEndDelegate(ptr, function ? new ScriptUIEventDelegate(function) : 0);
+}
+
+/// Register the delegate properties of an element type. Called after the element template registration of each type.
+static void RegisterUIElementDelegates(asIScriptEngine* engine, const char* className)
+{
+    engine->RegisterObjectMethod(className, "void set_onClick(UIClickDelegate@)", asFUNCTION(UIElementSetOnClick), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod(className, "void set_onClickEnd(UIClickDelegate@)", asFUNCTION(UIElementSetOnClickEnd), asCALL_CDECL_OBJLAST);
+}
+
 static void RegisterUIElement(asIScriptEngine* engine)
 {
     engine->RegisterEnum("HorizontalAlignment");
@@ -89,6 +161,8 @@ static void RegisterUIElement(asIScriptEngine* engine)
     engine->RegisterGlobalProperty("const uint DD_SOURCE_AND_TARGET", (void*)&DD_SOURCE_AND_TARGET);
 
     RegisterUIElement<UIElement>(engine, "UIElement");
+    engine->RegisterFuncdef("void UIClickDelegate(UIElement@, int, int)");
+    RegisterUIElementDelegates(engine, "UIElement");
 
     // Register Variant GetPtr() for UIElement
     engine->RegisterObjectMethod("Variant", "UIElement@+ GetUIElement() const", asFUNCTION(GetVariantPtr<UIElement>), asCALL_CDECL_OBJLAST);
@@ -97,11 +171,13 @@ static void RegisterUIElement(asIScriptEngine* engine)
 static void RegisterBorderImage(asIScriptEngine* engine)
 {
     RegisterBorderImage<BorderImage>(engine, "BorderImage");
+    RegisterUIElementDelegates(engine, "BorderImage");
 }
 
 static void RegisterSprite(asIScriptEngine* engine)
 {
     RegisterUIElement<Sprite>(engine, "Sprite", true);
+    RegisterUIElementDelegates(engine, "Sprite");
     engine->RegisterObjectMethod("Sprite", "void SetPosition(float, float)", asMETHODPR(Sprite, SetPosition, (float, float), void), asCALL_THISCALL);
     engine->RegisterObjectMethod("Sprite", "void SetHotSpot(int, int)", asMETHODPR(Sprite, SetHotSpot, (int, int), void), asCALL_THISCALL);
     engine->RegisterObjectMethod("Sprite", "void SetScale(float, float)", asMETHODPR(Sprite, SetScale, (float, float), void), asCALL_THISCALL);
@@ -136,6 +212,7 @@ static void RegisterCursor(asIScriptEngine* engine)
     engine->RegisterEnumValue("CursorShape", "CS_BUSY", CS_BUSY);
 
     RegisterBorderImage<Cursor>(engine, "Cursor");
+    RegisterUIElementDelegates(engine, "Cursor");
     engine->RegisterObjectMethod("Cursor", "void DefineShape(CursorShape, Texture@+, const IntRect&in, const IntVector2&in)", asMETHOD(Cursor, DefineShape), asCALL_THISCALL);
     engine->RegisterObjectMethod("Cursor", "void set_shape(CursorShape)", asMETHOD(Cursor, SetShape), asCALL_THISCALL);
     engine->RegisterObjectMethod("Cursor", "CursorShape get_shape() const", asMETHOD(Cursor, GetShape), asCALL_THISCALL);
@@ -146,11 +223,13 @@ static void RegisterCursor(asIScriptEngine* engine)
 static void RegisterButton(asIScriptEngine* engine)
 {
     RegisterButton<Button>(engine, "Button");
+    RegisterUIElementDelegates(engine, "Button");
 }
 
 static void RegisterCheckBox(asIScriptEngine* engine)
 {
     RegisterBorderImage<CheckBox>(engine, "CheckBox");
+    RegisterUIElementDelegates(engine, "CheckBox");
     engine->RegisterObjectMethod("CheckBox", "void SetCheckedOffset(int, int)", asMETHODPR(CheckBox, SetCheckedOffset, (int, int), void), asCALL_THISCALL);
     engine->RegisterObjectMethod("CheckBox", "void set_checked(bool)", asMETHOD(CheckBox, SetChecked), asCALL_THISCALL);
     engine->RegisterObjectMethod("CheckBox", "bool get_checked() const", asMETHOD(CheckBox, IsChecked), asCALL_THISCALL);
@@ -161,6 +240,7 @@ static void RegisterCheckBox(asIScriptEngine* engine)
 static void RegisterSlider(asIScriptEngine* engine)
 {
     RegisterBorderImage<Slider>(engine, "Slider");
+    RegisterUIElementDelegates(engine, "Slider");
     engine->RegisterObjectMethod("Slider", "void ChangeValue(float)", asMETHOD(Slider, ChangeValue), asCALL_THISCALL);
     engine->RegisterObjectMethod("Slider", "void set_orientation(Orientation)", asMETHOD(Slider, SetOrientation), asCALL_THISCALL);
     engine->RegisterObjectMethod("Slider", "Orientation get_orientation() const", asMETHOD(Slider, GetOrientation), asCALL_THISCALL);
@@ -176,6 +256,7 @@ static void RegisterSlider(asIScriptEngine* engine)
 static void RegisterScrollBar(asIScriptEngine* engine)
 {
     RegisterUIElement<ScrollBar>(engine, "ScrollBar");
+    RegisterUIElementDelegates(engine, "ScrollBar");
     engine->RegisterObjectMethod("ScrollBar", "void ChangeValue(float)", asMETHOD(ScrollBar, ChangeValue), asCALL_THISCALL);
     engine->RegisterObjectMethod("ScrollBar", "void StepBack()", asMETHOD(ScrollBar, StepBack), asCALL_THISCALL);
     engine->RegisterObjectMethod("ScrollBar", "void StepForward()", asMETHOD(ScrollBar, StepForward), asCALL_THISCALL);
@@ -198,6 +279,7 @@ static void RegisterScrollBar(asIScriptEngine* engine)
 static void RegisterScrollView(asIScriptEngine* engine)
 {
     RegisterUIElement<ScrollView>(engine, "ScrollView");
+    RegisterUIElementDelegates(engine, "ScrollView");
     engine->RegisterObjectMethod("ScrollView", "void SetViewPosition(int, int)", asMETHODPR(ScrollView, SetViewPosition, (int, int), void), asCALL_THISCALL);
     engine->RegisterObjectMethod("ScrollView", "void SetScrollBarsVisible(bool, bool)", asMETHOD(ScrollView, SetScrollBarsVisible), asCALL_THISCALL);
     engine->RegisterObjectMethod("ScrollView", "void set_contentElement(UIElement@+)", asMETHOD(ScrollView, SetContentElement), asCALL_THISCALL);
@@ -252,6 +334,7 @@ static void RegisterListView(asIScriptEngine* engine)
     engine->RegisterEnumValue("HighlightMode", "HM_ALWAYS", HM_ALWAYS);
 
     RegisterUIElement<ListView>(engine, "ListView");
+    RegisterUIElementDelegates(engine, "ListView");
     engine->RegisterObjectMethod("ListView", "void SetViewPosition(int, int)", asMETHODPR(ListView, SetViewPosition, (int, int), void), asCALL_THISCALL);
     engine->RegisterObjectMethod("ListView", "void SetScrollBarsVisible(bool, bool)", asMETHOD(ListView, SetScrollBarsVisible), asCALL_THISCALL);
     engine->RegisterObjectMethod("ListView", "void AddItem(UIElement@+)", asMETHOD(ListView, AddItem), asCALL_THISCALL);
@@ -310,6 +393,7 @@ static void RegisterText(asIScriptEngine* engine)
     engine->RegisterEnumValue("TextEffect", "TE_STROKE", TE_STROKE);
 
     RegisterUIElement<Text>(engine, "Text");
+    RegisterUIElementDelegates(engine, "Text");
     engine->RegisterObjectMethod("Text", "bool SetFont(const String&in, int)", asMETHODPR(Text, SetFont, (const String&, int), bool), asCALL_THISCALL);
     engine->RegisterObjectMethod("Text", "bool SetFont(Font@+, int)", asMETHODPR(Text, SetFont, (Font*, int), bool), asCALL_THISCALL);
     engine->RegisterObjectMethod("Text", "void SetSelection(uint, uint arg1 = M_MAX_UNSIGNED)", asMETHOD(Text, SetSelection), asCALL_THISCALL);
@@ -382,6 +466,7 @@ static void RegisterText3D(asIScriptEngine* engine)
 static void RegisterLineEdit(asIScriptEngine* engine)
 {
     RegisterBorderImage<LineEdit>(engine, "LineEdit");
+    RegisterUIElementDelegates(engine, "LineEdit");
     engine->RegisterObjectMethod("LineEdit", "void set_text(const String&in)", asMETHOD(LineEdit, SetText), asCALL_THISCALL);
     engine->RegisterObjectMethod("LineEdit", "const String& get_text() const", asMETHOD(LineEdit, GetText), asCALL_THISCALL);
     engine->RegisterObjectMethod("LineEdit", "void set_cursorPosition(uint)", asMETHOD(LineEdit, SetCursorPosition), asCALL_THISCALL);
@@ -405,6 +490,7 @@ static void RegisterLineEdit(asIScriptEngine* engine)
 static void RegisterMenu(asIScriptEngine* engine)
 {
     RegisterButton<Menu>(engine, "Menu");
+    RegisterUIElementDelegates(engine, "Menu");
     engine->RegisterObjectMethod("Menu", "void SetPopupOffset(int, int)", asMETHODPR(Menu, SetPopupOffset, (int, int), void), asCALL_THISCALL);
     engine->RegisterObjectMethod("Menu", "void SetAccelerator(int, int)", asMETHOD(Menu, SetAccelerator), asCALL_THISCALL);
     engine->RegisterObjectMethod("Menu", "void set_popup(UIElement@+)", asMETHOD(Menu, SetPopup), asCALL_THISCALL);
@@ -426,6 +512,7 @@ static CScriptArray* DropDownListGetItems(DropDownList* ptr)
 static void RegisterDropDownList(asIScriptEngine* engine)
 {
     RegisterButton<DropDownList>(engine, "DropDownList");
+    RegisterUIElementDelegates(engine, "DropDownList");
     engine->RegisterObjectMethod("DropDownList", "void SetAccelerator(int, int)", asMETHOD(DropDownList, SetAccelerator), asCALL_THISCALL);
     engine->RegisterObjectMethod("DropDownList", "void AddItem(UIElement@+)", asMETHOD(DropDownList, AddItem), asCALL_THISCALL);
     engine->RegisterObjectMethod("DropDownList", "void InsertItem(uint, UIElement@+)", asMETHOD(DropDownList, InsertItem), asCALL_THISCALL);
@@ -454,11 +541,13 @@ static void RegisterDropDownList(asIScriptEngine* engine)
 static void RegisterWindow(asIScriptEngine* engine)
 {
     RegisterWindow<Window>(engine, "Window");
+    RegisterUIElementDelegates(engine, "Window");
 }
 
 static void RegisterView3D(asIScriptEngine* engine)
 {
     RegisterWindow<View3D>(engine, "View3D");
+    RegisterUIElementDelegates(engine, "View3D");
     engine->RegisterObjectMethod("View3D", "void SetView(Scene@+, Camera@+)", asMETHOD(View3D, SetView), asCALL_THISCALL);
     engine->RegisterObjectMethod("View3D", "void QueueUpdate()", asMETHOD(View3D, QueueUpdate), asCALL_THISCALL);
     engine->RegisterObjectMethod("View3D", "void set_format(uint)", asMETHOD(View3D, SetFormat), asCALL_THISCALL);
@@ -515,9 +604,96 @@ static void RegisterFileSelector(asIScriptEngine* engine)
     engine->RegisterObjectMethod("FileSelector", "Button@+ get_cancelButton() const", asMETHOD(FileSelector, GetCancelButton), asCALL_THISCALL);
 }
 
-static UI* GetUI()
+static void ConstructUIFrameStats(UIFrameStats* ptr)
 {
-    return GetScriptContext()->GetSubsystem<UI>();
+    new(ptr) UIFrameStats();
+}
+
+static void RegisterUIFrameStats(asIScriptEngine* engine)
+{
+    engine->RegisterObjectType("UIFrameStats", sizeof(UIFrameStats), asOBJ_VALUE | asOBJ_POD | asOBJ_APP_CLASS_C);
+    engine->RegisterObjectBehaviour("UIFrameStats", asBEHAVE_CONSTRUCT, "void f()", asFUNCTION(ConstructUIFrameStats), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("UIFrameStats", "void Reset()", asMETHOD(UIFrameStats, Reset), asCALL_THISCALL);
+    engine->RegisterObjectProperty("UIFrameStats", "uint elementsVisited", offsetof(UIFrameStats, elementsVisited_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint batches", offsetof(UIFrameStats, batches_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint drawCalls", offsetof(UIFrameStats, drawCalls_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint vertices", offsetof(UIFrameStats, vertices_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint uploadedBytes", offsetof(UIFrameStats, uploadedBytes_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint hitTests", offsetof(UIFrameStats, hitTests_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint eventsSent", offsetof(UIFrameStats, eventsSent_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint glyphMisses", offsetof(UIFrameStats, glyphMisses_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint tasksRun", offsetof(UIFrameStats, tasksRun_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint taskBacklog", offsetof(UIFrameStats, taskBacklog_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint taskTime", offsetof(UIFrameStats, taskTime_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint updateTime", offsetof(UIFrameStats, updateTime_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint renderUpdateTime", offsetof(UIFrameStats, renderUpdateTime_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint renderTime", offsetof(UIFrameStats, renderTime_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint updateAllocations", offsetof(UIFrameStats, updateAllocations_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint updateAllocatedBytes", offsetof(UIFrameStats, updateAllocatedBytes_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint renderUpdateAllocations", offsetof(UIFrameStats, renderUpdateAllocations_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint renderUpdateAllocatedBytes", offsetof(UIFrameStats, renderUpdateAllocatedBytes_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint renderAllocations", offsetof(UIFrameStats, renderAllocations_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint renderAllocatedBytes", offsetof(UIFrameStats, renderAllocatedBytes_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint inputAllocations", offsetof(UIFrameStats, inputAllocations_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint inputAllocatedBytes", offsetof(UIFrameStats, inputAllocatedBytes_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint glyphAllocations", offsetof(UIFrameStats, glyphAllocations_));
+    engine->RegisterObjectProperty("UIFrameStats", "uint glyphAllocatedBytes", offsetof(UIFrameStats, glyphAllocatedBytes_));
+}
+
+static UIObservable* ConstructUIObservable()
+{
+    return new UIObservable();
+}
+
+static unsigned UIAnimatorTween(UIElement* element, TweenProperty property, float to, float duration, EaseType ease, TweenLoopMode loopMode, UIAnimator* ptr)
+{
+    return ptr->Tween(element, property, to, duration, ease, loopMode);
+}
+
+static unsigned UIAnimatorTweenFromTo(UIElement* element, TweenProperty property, float from, float to, float duration, EaseType ease, TweenLoopMode loopMode, UIAnimator* ptr)
+{
+    return ptr->Tween(element, property, from, to, duration, ease, loopMode);
+}
+
+static void RegisterUIAnimator(asIScriptEngine* engine)
+{
+    engine->RegisterEnum("TweenProperty");
+    engine->RegisterEnumValue("TweenProperty", "TP_OPACITY", TP_OPACITY);
+    engine->RegisterEnumValue("TweenProperty", "TP_POSITION_X", TP_POSITION_X);
+    engine->RegisterEnumValue("TweenProperty", "TP_POSITION_Y", TP_POSITION_Y);
+    engine->RegisterEnumValue("TweenProperty", "TP_WIDTH", TP_WIDTH);
+    engine->RegisterEnumValue("TweenProperty", "TP_HEIGHT", TP_HEIGHT);
+
+    engine->RegisterEnum("EaseType");
+    engine->RegisterEnumValue("EaseType", "EASE_LINEAR", EASE_LINEAR);
+    engine->RegisterEnumValue("EaseType", "EASE_IN_QUAD", EASE_IN_QUAD);
+    engine->RegisterEnumValue("EaseType", "EASE_OUT_QUAD", EASE_OUT_QUAD);
+    engine->RegisterEnumValue("EaseType", "EASE_IN_OUT_QUAD", EASE_IN_OUT_QUAD);
+    engine->RegisterEnumValue("EaseType", "EASE_SMOOTHSTEP", EASE_SMOOTHSTEP);
+
+    engine->RegisterEnum("TweenLoopMode");
+    engine->RegisterEnumValue("TweenLoopMode", "TLM_ONCE", TLM_ONCE);
+    engine->RegisterEnumValue("TweenLoopMode", "TLM_LOOP", TLM_LOOP);
+    engine->RegisterEnumValue("TweenLoopMode", "TLM_PINGPONG", TLM_PINGPONG);
+
+    RegisterRefCounted<UIAnimator>(engine, "UIAnimator");
+    engine->RegisterObjectMethod("UIAnimator", "uint Tween(UIElement@+, TweenProperty, float, float, EaseType ease = EASE_LINEAR, TweenLoopMode loopMode = TLM_ONCE)", asFUNCTION(UIAnimatorTween), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("UIAnimator", "uint Tween(UIElement@+, TweenProperty, float, float, float, EaseType ease = EASE_LINEAR, TweenLoopMode loopMode = TLM_ONCE)", asFUNCTION(UIAnimatorTweenFromTo), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("UIAnimator", "void Stop(uint)", asMETHODPR(UIAnimator, Stop, (unsigned), void), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UIAnimator", "void Stop(UIElement@+)", asMETHODPR(UIAnimator, Stop, (UIElement*), void), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UIAnimator", "void StopAll()", asMETHOD(UIAnimator, StopAll), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UIAnimator", "bool IsActive(uint) const", asMETHOD(UIAnimator, IsActive), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UIAnimator", "bool IsAnimating(UIElement@+) const", asMETHOD(UIAnimator, IsAnimating), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UIAnimator", "uint get_numTweens() const", asMETHOD(UIAnimator, GetNumTweens), asCALL_THISCALL);
+}
+
+static void RegisterUIObservable(asIScriptEngine* engine)
+{
+    RegisterRefCounted<UIObservable>(engine, "UIObservable");
+    engine->RegisterObjectBehaviour("UIObservable", asBEHAVE_FACTORY, "UIObservable@+ f()", asFUNCTION(ConstructUIObservable), asCALL_CDECL);
+    engine->RegisterObjectMethod("UIObservable", "void set_value(const Variant&in)", asMETHOD(UIObservable, SetValue), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UIObservable", "const Variant& get_value() const", asMETHOD(UIObservable, GetValue), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UIObservable", "uint get_version() const", asMETHOD(UIObservable, GetVersion), asCALL_THISCALL);
 }
 
 static UIElement* UILoadLayoutFromFile(File* file, UI* ptr)
@@ -567,6 +743,53 @@ static bool UISaveLayout(File* file, UIElement* element, UI* ptr)
     return file && ptr->SaveLayout(*file, element);
 }
 
+static void UISetTexts(CScriptArray* elements, CScriptArray* texts, UI* ptr)
+{
+    if (!elements || !texts)
+        return;
+
+    unsigned numElements = elements->GetSize();
+    PODVector<UIElement*> destElements(numElements);
+    for (unsigned i = 0; i < numElements; ++i)
+        destElements[i] = *(static_cast<UIElement**>(elements->At(i)));
+
+    unsigned numTexts = texts->GetSize();
+    Vector<String> destTexts(numTexts);
+    for (unsigned i = 0; i < numTexts; ++i)
+        destTexts[i] = *(static_cast<String*>(texts->At(i)));
+
+    ptr->SetTexts(destElements, destTexts);
+}
+
+static void UISetPositions(CScriptArray* elements, CScriptArray* positions, UI* ptr)
+{
+    if (!elements || !positions)
+        return;
+
+    unsigned numElements = elements->GetSize();
+    PODVector<UIElement*> destElements(numElements);
+    for (unsigned i = 0; i < numElements; ++i)
+        destElements[i] = *(static_cast<UIElement**>(elements->At(i)));
+
+    unsigned numPositions = positions->GetSize();
+    PODVector<IntVector2> destPositions(numPositions);
+    for (unsigned i = 0; i < numPositions; ++i)
+        destPositions[i] = *(static_cast<IntVector2*>(positions->At(i)));
+
+    ptr->SetPositions(destElements, destPositions);
+}
+
+static CScriptArray* UIGetElementsWithTag(const String& tag, UI* ptr)
+{
+    PODVector<UIElement*> result = ptr->GetElementsWithTag(tag);
+    return VectorToHandleArray<UIElement>(result, "Array<UIElement@>");
+}
+
+static CScriptArray* UIGetReplayFrameStats(UI* ptr)
+{
+    return VectorToArray<UIFrameStats>(ptr->GetReplayFrameStats(), "Array<UIFrameStats>");
+}
+
 static void RegisterUI(asIScriptEngine* engine)
 {
     RegisterObject<UI>(engine, "UI");
@@ -580,6 +803,37 @@ static void RegisterUI(asIScriptEngine* engine)
     engine->RegisterObjectMethod("UI", "UIElement@+ GetElementAt(const IntVector2&in, bool activeOnly = true)", asMETHODPR(UI, GetElementAt, (const IntVector2&, bool), UIElement*), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "UIElement@+ GetElementAt(int, int, bool activeOnly = true)", asMETHODPR(UI, GetElementAt, (int, int, bool), UIElement*), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "bool HasModalElement() const", asMETHOD(UI, HasModalElement), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "bool DefineHardwareCursorShape(CursorShape, Image@+, const IntRect&in, const IntVector2&in)", asMETHOD(UI, DefineHardwareCursorShape), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "bool SetHardwareCursor(bool)", asMETHOD(UI, SetHardwareCursor), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void SetCompositionText(const String&in, uint cursor = 0xffffffff)", asMETHOD(UI, SetCompositionText), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void SetCompositionFont(Font@+, int)", asMETHOD(UI, SetCompositionFont), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void CommitText(const String&in)", asMETHOD(UI, CommitText), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "bool RenderToImage(Image@+, const Color&in clearColor = Color(0, 0, 0, 0))", asMETHOD(UI, RenderToImage), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void SetSoftwareTextureImage(Texture@+, Image@+)", asMETHOD(UI, SetSoftwareTextureImage), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void SetTexts(Array<UIElement@>@+, Array<String>@+)", asFUNCTION(UISetTexts), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("UI", "void SetPositions(Array<UIElement@>@+, Array<IntVector2>@+)", asFUNCTION(UISetPositions), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("UI", "void QueueSetText(UIElement@+, const String&in)", asMETHOD(UI, QueueSetText), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void QueueSetPosition(UIElement@+, const IntVector2&in)", asMETHOD(UI, QueueSetPosition), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void QueueSetColor(UIElement@+, const Color&in)", asMETHOD(UI, QueueSetColor), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void QueueSetVisible(UIElement@+, bool)", asMETHOD(UI, QueueSetVisible), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void QueueSetOpacity(UIElement@+, float)", asMETHOD(UI, QueueSetOpacity), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void ApplyCommands()", asMETHOD(UI, ApplyCommands), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void DeferLayout(UIElement@+)", asMETHOD(UI, DeferLayout), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void FlushLayouts()", asMETHOD(UI, FlushLayouts), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void Bind(UIElement@+, const String&in, UIObservable@+)", asMETHOD(UI, Bind), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void Unbind(UIElement@+, const String&in)", asMETHOD(UI, Unbind), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void UnbindAll(UIElement@+)", asMETHOD(UI, UnbindAll), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void ApplyBindings()", asMETHOD(UI, ApplyBindings), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "UIElement@+ FindElement(const String&in)", asMETHOD(UI, FindElement), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void AddTag(UIElement@+, const String&in)", asMETHOD(UI, AddTag), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void RemoveTag(UIElement@+, const String&in)", asMETHOD(UI, RemoveTag), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void RemoveAllTags(UIElement@+)", asMETHOD(UI, RemoveAllTags), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "bool HasTag(UIElement@+, const String&in) const", asMETHOD(UI, HasTag), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "Array<UIElement@>@ GetElementsWithTag(const String&in)", asFUNCTION(UIGetElementsWithTag), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("UI", "bool BeginInputRecording(const String&in)", asMETHOD(UI, BeginInputRecording), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void EndInputRecording()", asMETHOD(UI, EndInputRecording), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "bool BeginInputReplay(const String&in)", asMETHOD(UI, BeginInputReplay), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void EndInputReplay()", asMETHOD(UI, EndInputReplay), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "void set_cursor(Cursor@+)", asMETHOD(UI, SetCursor), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "Cursor@+ get_cursor() const", asMETHOD(UI, GetCursor), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "IntVector2 get_cursorPosition() const", asMETHOD(UI, GetCursorPosition), asCALL_THISCALL);
@@ -596,6 +850,36 @@ static void RegisterUI(asIScriptEngine* engine)
     engine->RegisterObjectMethod("UI", "bool get_nonFocusedMouseWheel() const", asMETHOD(UI, IsNonFocusedMouseWheel), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "void set_useSystemClipBoard(bool)", asMETHOD(UI, SetUseSystemClipBoard), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "bool get_useSystemClipBoard() const", asMETHOD(UI, GetUseSystemClipBoard), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "bool get_hardwareCursor() const", asMETHOD(UI, IsHardwareCursor), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "const String& get_compositionText() const", asMETHOD(UI, GetCompositionText), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "uint get_compositionCursor() const", asMETHOD(UI, GetCompositionCursor), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void set_compositionPosition(const IntVector2&in)", asMETHOD(UI, SetCompositionPosition), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "const IntVector2& get_compositionPosition() const", asMETHOD(UI, GetCompositionPosition), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "Font@+ get_compositionFont() const", asMETHOD(UI, GetCompositionFont), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "int get_compositionFontSize() const", asMETHOD(UI, GetCompositionFontSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void set_compositionColor(const Color&in)", asMETHOD(UI, SetCompositionColor), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "const Color& get_compositionColor() const", asMETHOD(UI, GetCompositionColor), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "bool get_composing() const", asMETHOD(UI, IsComposing), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "UIAnimator@+ get_animator() const", asMETHOD(UI, GetAnimator), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "const UIFrameStats& get_frameStats() const", asMETHOD(UI, GetFrameStats), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void set_pipelinedBatching(bool)", asMETHOD(UI, SetPipelinedBatching), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "bool get_pipelinedBatching() const", asMETHOD(UI, GetPipelinedBatching), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "bool SetAllocationCheck(bool)", asMETHOD(UI, SetAllocationCheck), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "bool get_allocationCheck() const", asMETHOD(UI, GetAllocationCheck), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "uint get_allocationCheckFailures() const", asMETHOD(UI, GetAllocationCheckFailures), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void set_coalesceDragMoves(bool)", asMETHOD(UI, SetCoalesceDragMoves), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "bool get_coalesceDragMoves() const", asMETHOD(UI, GetCoalesceDragMoves), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "uint get_numDeferredLayouts() const", asMETHOD(UI, GetNumDeferredLayouts), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "uint get_numBindings() const", asMETHOD(UI, GetNumBindings), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void RemoveAllTasks()", asMETHOD(UI, RemoveAllTasks), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void set_taskBudget(float)", asMETHOD(UI, SetTaskBudget), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "float get_taskBudget() const", asMETHOD(UI, GetTaskBudget), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "uint get_taskBacklog() const", asMETHOD(UI, GetTaskBacklog), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "uint get_taskBudgetOverruns() const", asMETHOD(UI, GetTaskBudgetOverruns), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "uint get_numQueuedCommands() const", asMETHOD(UI, GetNumQueuedCommands), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "bool get_recordingInput() const", asMETHOD(UI, IsRecordingInput), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "bool get_replayingInput() const", asMETHOD(UI, IsReplayingInput), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "Array<UIFrameStats>@ get_replayFrameStats() const", asFUNCTION(UIGetReplayFrameStats), asCALL_CDECL_OBJLAST);
     engine->RegisterGlobalFunction("UI@+ get_ui()", asFUNCTION(GetUI), asCALL_CDECL);
 }
 
@@ -620,6 +904,9 @@ void RegisterUIAPI(asIScriptEngine* engine)
     RegisterWindow(engine);
     RegisterView3D(engine);
     RegisterFileSelector(engine);
+    RegisterUIFrameStats(engine);
+    RegisterUIObservable(engine);
+    RegisterUIAnimator(engine);
     RegisterUI(engine);
 }
 
@@ -27,12 +27,16 @@
 #include "FileSystem.h"
 #include "Font.h"
 #include "Graphics.h"
+#include "Image.h"
 #include "Log.h"
 #include "MemoryBuffer.h"
 #include "Profiler.h"
 #include "ResourceCache.h"
 #include "StringUtils.h"
 #include "Texture2D.h"
+#include "Thread.h"
+#include "UI.h"
+#include "UIAllocation.h"
 #include "XMLFile.h"
 
 #include <ft2build.h>
@@ -49,6 +53,22 @@ static const int MAX_POINT_SIZE = 48;
 static const int MAX_ASCII_CODE = 127;
 static const int MIN_TEXTURE_SIZE = 128;
 static const int MAX_TEXTURE_SIZE = 2048;
+static const unsigned MAX_GLYPH_METRICS = 4096;
+
+/// Whether a worker thread build may be reading glyphs. Changed by the main thread only.
+static bool workerBuildActive = false;
+/// Whether the worker thread build missed glyphs or faces, or used glyphs that were evicted during it.
+static bool workerBuildStale = false;
+/// Faces with glyphs pinned by the worker thread build.
+static PODVector<FontFaceTTF*> facesWithPinnedGlyphs;
+/// Mutex for the worker thread build state.
+static Mutex workerBuildMutex;
+/// Glyphs rendered on demand. Only the main thread renders glyphs.
+static unsigned numGlyphMisses = 0;
+/// Heap allocations made rendering glyphs on demand.
+static unsigned glyphMissAllocations = 0;
+/// Heap bytes allocated rendering glyphs on demand.
+static unsigned glyphMissAllocatedBytes = 0;
 
 /// FreeType library subsystem.
 class FreeTypeLibrary : public Object
@@ -111,7 +131,8 @@ FontGlyph::FontGlyph()
 }
 
 FontFace::FontFace(Font* font, int pointSize) : font_(font),
-    pointSize_(pointSize)
+    pointSize_(pointSize),
+    generation_(0)
 {
 }
 
@@ -129,6 +150,11 @@ const FontGlyph* FontFace::GetGlyph(unsigned c) const
     return 0;
 }
 
+const FontGlyph* FontFace::GetGlyphMetrics(unsigned c) const
+{
+    return FontFace::GetGlyph(c);
+}
+
 short FontFace::GetKerning(unsigned c, unsigned d) const
 {
     if (kerningMapping_.Empty())
@@ -163,7 +189,50 @@ unsigned FontFace::GetTotalTextureSize() const
     return totalTextureSize;
 }
 
-MutableFontGlyph::MutableFontGlyph() : charCode_(0)
+void FontFace::BeginWorkerBuild()
+{
+    MutexLock lock(workerBuildMutex);
+    workerBuildActive = true;
+    workerBuildStale = false;
+}
+
+unsigned FontFace::GetNumGlyphMisses()
+{
+    return numGlyphMisses;
+}
+
+unsigned FontFace::GetGlyphMissAllocations()
+{
+    return glyphMissAllocations;
+}
+
+unsigned FontFace::GetGlyphMissAllocatedBytes()
+{
+    return glyphMissAllocatedBytes;
+}
+
+bool FontFace::EndWorkerBuild()
+{
+    // Take the list first, as the worker locks a face before the list
+    PODVector<FontFaceTTF*> faces;
+    bool stale;
+    {
+        MutexLock lock(workerBuildMutex);
+        faces.Swap(facesWithPinnedGlyphs);
+        stale = workerBuildStale;
+        workerBuildActive = false;
+        workerBuildStale = false;
+    }
+
+    for (unsigned i = 0; i < faces.Size(); ++i)
+        faces[i]->ReleasePinnedGlyphs();
+
+    return stale;
+}
+
+MutableFontGlyph::MutableFontGlyph() :
+    charCode_(0),
+    pinned_(false)
 {
 
 }
@@ -176,6 +245,11 @@ FontFaceTTF::FontFaceTTF(Font* font, int pointSize) : FontFace(font, pointSize),
 
 FontFaceTTF::~FontFaceTTF()
 {
+    {
+        MutexLock lock(workerBuildMutex);
+        facesWithPinnedGlyphs.Remove(this);
+    }
+
    for (List<MutableFontGlyph*>::Iterator i = mutableGlyphList.Begin(); i != mutableGlyphList.End(); ++i)
        delete (*i);
 }
@@ -399,6 +473,9 @@ const FontGlyph* FontFaceTTF::GetGlyph(unsigned c) const
     if (mutableGlyphList.Empty() || c <= MAX_ASCII_CODE)
         return FontFace::GetGlyph(c);
 
+    // The UI may build its batches on a worker thread while 3D text is updated on the main thread
+    MutexLock lock(glyphMutex_);
+
     HashMap<unsigned, MutableFontGlyph*>::ConstIterator i = mutableGlyphMapping_.Find(c);
     if (i != mutableGlyphMapping_.End())
     {
@@ -408,40 +485,86 @@ const FontGlyph* FontFaceTTF::GetGlyph(unsigned c) const
         mutableGlyphList.PushFront(glyph);
         glyph->iterator_ = mutableGlyphList.Begin();
 
+        if (!Thread::IsMainThread())
+            PinGlyph(glyph);
+
         return glyph;
     }
 
+    // Rendering evicts glyphs and updates the texture, which only the main thread may do. The worker build is redone
+    if (!Thread::IsMainThread())
+    {
+        MutexLock workerLock(workerBuildMutex);
+        workerBuildStale = true;
+        return 0;
+    }
+
+    return RenderGlyph(c);
+}
+
+const FontGlyph* FontFaceTTF::RenderGlyph(unsigned c) const
+{
+    // Count the heap allocations of rendering the glyph. FreeType's own allocations do not go through operator new
+    UIAllocationScope allocationScope(glyphMissAllocations, glyphMissAllocatedBytes);
+    ++numGlyphMisses;
+
+    // Find the least recently used slot that a worker thread build is not reading
+    List<MutableFontGlyph*>::Iterator slot = mutableGlyphList.End();
+    while (slot != mutableGlyphList.Begin())
+    {
+        --slot;
+        if (!(*slot)->pinned_)
+            break;
+    }
+    if ((*slot)->pinned_)
+        return 0;
+
     FT_Face face = (FT_Face)face_;
-    FT_GlyphSlot slot = face->glyph;
+    FT_GlyphSlot glyphSlot = face->glyph;
     FT_Pos ascender = face->size->metrics.ascender;
     FT_Error error = FT_Load_Char(face, c, FT_LOAD_RENDER);
     if (error)
         return 0;
 
-    MutableFontGlyph* glyph = mutableGlyphList.Back();
+    MutableFontGlyph* glyph = *slot;
     mutableGlyphList.Erase(glyph->iterator_);
     mutableGlyphList.PushFront(glyph);
     glyph->iterator_ = mutableGlyphList.Begin();
 
     if (glyph->charCode_ != 0)
+    {
         mutableGlyphMapping_.Erase(glyph->charCode_);
+        ++generation_;
+
+        // A worker build may have used cached quads of the evicted glyph
+        if (workerBuildActive)
+        {
+            MutexLock workerLock(workerBuildMutex);
+            workerBuildStale = true;
+        }
+    }
     glyph->charCode_ = c;
     mutableGlyphMapping_[glyph->charCode_] = glyph;
-
-    glyph->width_ = (short)((slot->metrics.width) >> 6);
-    glyph->height_ = (short)((slot->metrics.height) >> 6);
-    glyph->offsetX_ = (short)((slot->metrics.horiBearingX) >> 6);
-    glyph->offsetY_ = (short)((ascender - slot->metrics.horiBearingY) >> 6);
-    glyph->advanceX_ = (short)((slot->metrics.horiAdvance) >> 6);
-
-    SharedArrayPtr<unsigned char> data(new unsigned char[maxGlyphWidth_ * maxGlyphHeight_]);
+    // The resident glyph answers metrics queries from now on
+    glyphMetrics_.Erase(c);
+
+    glyph->width_ = (short)((glyphSlot->metrics.width) >> 6);
+    glyph->height_ = (short)((glyphSlot->metrics.height) >> 6);
+    glyph->offsetX_ = (short)((glyphSlot->metrics.horiBearingX) >> 6);
+    glyph->offsetY_ = (short)((ascender - glyphSlot->metrics.horiBearingY) >> 6);
+    glyph->advanceX_ = (short)((glyphSlot->metrics.horiAdvance) >> 6);
+
+    // The bitmap is uploaded immediately, so one buffer per face is enough
+    if (!glyphData_)
+        glyphData_ = new unsigned char[maxGlyphWidth_ * maxGlyphHeight_];
+    unsigned char* data = glyphData_.Get();
     memset(data, 0, maxGlyphWidth_ * maxGlyphHeight_);
 
-    if (slot->bitmap.pixel_mode == FT_PIXEL_MODE_MONO)
+    if (glyphSlot->bitmap.pixel_mode == FT_PIXEL_MODE_MONO)
     {
         for (int y = 0; y < glyph->height_; ++y)
         {
-            unsigned char* src = slot->bitmap.buffer + slot->bitmap.pitch * y;
+            unsigned char* src = glyphSlot->bitmap.buffer + glyphSlot->bitmap.pitch * y;
             unsigned char* dest = data + maxGlyphWidth_ * y;
             for (int w = 0; w < glyph->width_; ++w)
                 dest[w] = (src[w / 8] & (0x80 >> (w & 7))) ? 0xFF : 0x00;
@@ -451,17 +574,95 @@ const FontGlyph* FontFaceTTF::GetGlyph(unsigned c) const
     {
         for (int y = 0; y < glyph->height_; ++y)
         {
-            unsigned char* src = slot->bitmap.buffer + slot->bitmap.pitch * y;
+            unsigned char* src = glyphSlot->bitmap.buffer + glyphSlot->bitmap.pitch * y;
             unsigned char* dest = data + maxGlyphWidth_ * y;
             memcpy(dest, src, glyph->width_);
         }
     }
 
-    textures_[0]->SetData(0, glyph->x_, glyph->y_, maxGlyphWidth_, maxGlyphHeight_, data);
+    if (images_.Empty())
+        textures_[0]->SetData(0, glyph->x_, glyph->y_, maxGlyphWidth_, maxGlyphHeight_, data);
+    else
+    {
+        Image* image = images_[0];
+        for (int y = 0; y < maxGlyphHeight_; ++y)
+            memcpy(image->GetData() + image->GetWidth() * (glyph->y_ + y) + glyph->x_, data + maxGlyphWidth_ * y, maxGlyphWidth_);
+    }
 
     return glyph;
 }
 
+const FontGlyph* FontFaceTTF::GetGlyphMetrics(unsigned c) const
+{
+    if (mutableGlyphList.Empty() || c <= MAX_ASCII_CODE)
+        return FontFace::GetGlyph(c);
+
+    MutexLock lock(glyphMutex_);
+
+    // If the glyph is already in the texture use it, but do not change its position in the LRU list
+    HashMap<unsigned, MutableFontGlyph*>::ConstIterator i = mutableGlyphMapping_.Find(c);
+    if (i != mutableGlyphMapping_.End())
+    {
+        if (!Thread::IsMainThread())
+            PinGlyph(i->second_);
+        return i->second_;
+    }
+
+    HashMap<unsigned, FontGlyph>::ConstIterator j = glyphMetrics_.Find(c);
+    if (j != glyphMetrics_.End())
+        return &(j->second_);
+
+    // Load the outline only, rendering is deferred until the glyph is actually drawn
+    FT_Face face = (FT_Face)face_;
+    FT_GlyphSlot slot = face->glyph;
+    FT_Pos ascender = face->size->metrics.ascender;
+    FT_Error error = FT_Load_Char(face, c, FT_LOAD_DEFAULT);
+    if (error)
+        return 0;
+
+    // Glyphs that are measured but never rendered would otherwise accumulate. Like the erase in RenderGlyph(), only the main
+    // thread removes entries, as it is the only one that reads them after releasing the lock
+    if (glyphMetrics_.Size() >= MAX_GLYPH_METRICS && Thread::IsMainThread())
+        glyphMetrics_.Clear();
+
+    FontGlyph glyph;
+    glyph.x_ = 0;
+    glyph.y_ = 0;
+    glyph.width_ = (short)((slot->metrics.width) >> 6);
+    glyph.height_ = (short)((slot->metrics.height) >> 6);
+    glyph.offsetX_ = (short)((slot->metrics.horiBearingX) >> 6);
+    glyph.offsetY_ = (short)((ascender - slot->metrics.horiBearingY) >> 6);
+    glyph.advanceX_ = (short)((slot->metrics.horiAdvance) >> 6);
+    glyph.page_ = 0;
+
+    HashMap<unsigned, FontGlyph>::Iterator k = glyphMetrics_.Insert(MakePair(c, glyph));
+    return &(k->second_);
+}
+
+void FontFaceTTF::PinGlyph(MutableFontGlyph* glyph) const
+{
+    // Keep the glyph in its slot until the worker build has been rendered
+    if (glyph->pinned_)
+        return;
+
+    glyph->pinned_ = true;
+    if (pinnedGlyphs_.Empty())
+    {
+        MutexLock workerLock(workerBuildMutex);
+        facesWithPinnedGlyphs.Push(const_cast<FontFaceTTF*>(this));
+    }
+    pinnedGlyphs_.Push(glyph);
+}
+
+void FontFaceTTF::ReleasePinnedGlyphs()
+{
+    MutexLock lock(glyphMutex_);
+
+    for (unsigned i = 0; i < pinnedGlyphs_.Size(); ++i)
+        pinnedGlyphs_[i]->pinned_ = false;
+    pinnedGlyphs_.Clear();
+}
+
 bool FontFaceTTF::CalculateTextureSize(int &texWidth, int &texHeight)
 {
     bool loadAllGlyphs = true;
@@ -520,12 +721,23 @@ SharedPtr<Texture2D> FontFaceTTF::CreateFaceTexture(int texWidth, int texHeight,
         return SharedPtr<Texture2D>();
 
     Graphics* graphcs = font_->GetContext()->GetSubsystem<Graphics>();
-    if (!graphcs)
-        return SharedPtr<Texture2D>();
 
     SharedPtr<Texture2D> texture(new Texture2D(font_->GetContext()));
     texture->SetMipsToSkip(QUALITY_LOW, 0);
     texture->SetNumLevels(1);
+
+    if (!graphcs)
+    {
+        // Without a graphics device keep the pixels in an image for software rendering. The texture still records the size and
+        // format, and identifies the page in batches
+        texture->SetSize(texWidth, texHeight, Graphics::GetAlphaFormat());
+        SharedPtr<Image> image(new Image(font_->GetContext()));
+        image->SetSize(texWidth, texHeight, 1);
+        image->SetData(texData);
+        images_.Push(image);
+        return texture;
+    }
+
     if (!texture->SetSize(texWidth, texHeight, graphcs->GetAlphaFormat()))
     {
         LOGERROR("Could not set texture size");
@@ -674,6 +886,35 @@ SharedPtr<Texture2D> FontFaceBitmap::CreateFaceTexture(SharedPtr<Image> image)
     SharedPtr<Texture2D> texture(new Texture2D(font_->GetContext()));
     texture->SetMipsToSkip(QUALITY_LOW, 0);
     texture->SetNumLevels(1);
+
+    if (!font_->GetContext()->GetSubsystem<Graphics>())
+    {
+        // Without a graphics device keep the image for software rendering, and record the format the texture would have
+        unsigned format;
+        switch (image->GetComponents())
+        {
+        case 1:
+            format = Graphics::GetAlphaFormat();
+            break;
+
+        case 2:
+            format = Graphics::GetLuminanceAlphaFormat();
+            break;
+
+        case 3:
+            format = Graphics::GetRGBFormat();
+            break;
+
+        default:
+            format = Graphics::GetRGBAFormat();
+            break;
+        }
+
+        texture->SetSize(image->GetWidth(), image->GetHeight(), format);
+        images_.Push(image);
+        return texture;
+    }
+
     if (!texture->Load(image, true))
     {
         LOGERROR("Could not load texture from image resource");
@@ -698,16 +939,27 @@ void Font::RegisterObject(Context* context)
     context->RegisterFactory<Font>();
 }
 
+/// Return whether fonts should load and create faces. In headless mode only when the UI renders to images in software.
+static bool HasFontRendering(Context* context)
+{
+    if (context->GetSubsystem<Graphics>())
+        return true;
+    UI* ui = context->GetSubsystem<UI>();
+    return ui && ui->IsSoftwareRendering();
+}
+
 bool Font::Load(Deserializer& source)
 {
     PROFILE(LoadFont);
 
     // In headless mode, do not actually load, just return success
-    Graphics* graphics = GetSubsystem<Graphics>();
-    if (!graphics)
+    if (!HasFontRendering(context_))
         return true;
 
-    faces_.Clear();
+    {
+        MutexLock lock(facesMutex_);
+        faces_.Clear();
+    }
 
     fontDataSize_ = source.GetSize();
     if (fontDataSize_)
@@ -735,8 +987,7 @@ bool Font::Load(Deserializer& source)
 const FontFace* Font::GetFace(int pointSize)
 {
     // In headless mode, always return null
-    Graphics* graphics = GetSubsystem<Graphics>();
-    if (!graphics)
+    if (!HasFontRendering(context_))
         return 0;
 
     // For bitmap font type, always return the same font face provided by the font's bitmap file regardless of the actual requested point size
@@ -745,10 +996,25 @@ const FontFace* Font::GetFace(int pointSize)
     else
         pointSize = Clamp(pointSize, MIN_POINT_SIZE, MAX_POINT_SIZE);
 
+    MutexLock lock(facesMutex_);
+
     HashMap<int, SharedPtr<FontFace> >::Iterator i = faces_.Find(pointSize);
+
+    // Creating a face creates textures, which only the main thread may do
+    if (!Thread::IsMainThread())
+    {
+        if (i != faces_.End() && !i->second_->IsDataLost())
+            return i->second_;
+
+        MutexLock workerLock(workerBuildMutex);
+        workerBuildStale = true;
+        return 0;
+    }
+
     if (i != faces_.End())
     {
-        if (!i->second_->IsDataLost())
+        // Keep a face a worker thread build may be using until the build ends
+        if (!i->second_->IsDataLost() || workerBuildActive)
             return i->second_;
         else
         {
@@ -24,6 +24,7 @@
 
 #include "ArrayPtr.h"
 #include "List.h"
+#include "Mutex.h"
 #include "Resource.h"
 
 namespace Urho3D
@@ -79,6 +80,8 @@ public:
     virtual bool Load(const unsigned char* fontData, unsigned fontDataSize) = 0;
     /// Return pointer to the glyph structure corresponding to a character. Return null if glyph not found.
     virtual const FontGlyph* GetGlyph(unsigned c) const;
+    /// Return pointer to the glyph structure corresponding to a character for measuring only. The glyph is not rendered to the texture and its texture position is not valid. Return null if glyph not found.
+    virtual const FontGlyph* GetGlyphMetrics(unsigned c) const;
     /// Return the kerning for a character and the next character.
     short GetKerning(unsigned c, unsigned d) const;
     /// Return true when one of the texture has a data loss.
@@ -86,6 +89,17 @@ public:
     /// Return total texture size.
     unsigned GetTotalTextureSize() const;
 
+    /// Return number of glyphs rendered to font textures on demand since startup.
+    static unsigned GetNumGlyphMisses();
+    /// Return heap allocations made rendering glyphs on demand since startup.
+    static unsigned GetGlyphMissAllocations();
+    /// Return heap bytes allocated rendering glyphs on demand since startup.
+    static unsigned GetGlyphMissAllocatedBytes();
+    /// Begin building batches on a worker thread. Until the build ends, glyphs the worker reads are not evicted, and faces are not recreated after data loss. Call from the main thread.
+    static void BeginWorkerBuild();
+    /// End the worker thread build and release its glyphs. Return true if the worker needed glyphs or faces that only the main thread can render, or used glyphs that were evicted during the build, in which case its batches should be rebuilt on the main thread. Call from the main thread after the worker has finished.
+    static bool EndWorkerBuild();
+
     /// Font.
     WeakPtr<Font> font_;
     /// Point size.
@@ -94,10 +108,14 @@ public:
     int rowHeight_;
     /// Texture.
     Vector<SharedPtr<Texture2D> > textures_;
+    /// Texture pixels kept on the CPU when there is no graphics device and the UI renders in software, one per texture, for software rendering. Empty when the textures hold the pixels.
+    Vector<SharedPtr<Image> > images_;
     /// Glyph mapping.
     HashMap<unsigned, FontGlyph> glyphMapping_;
     /// Kerning mapping.
     HashMap<unsigned, short> kerningMapping_;
+    /// Glyph generation. Incremented whenever a rendered glyph is evicted from the textures, so that cached texture coordinates can be validated.
+    mutable unsigned generation_;
 };
 
 /// Mutable font glyph description.
@@ -110,6 +128,8 @@ struct MutableFontGlyph : public FontGlyph
     unsigned charCode_;
     /// Iteractor.
     List<MutableFontGlyph*>::Iterator iterator_;
+    /// In use by a worker thread build, so must not be evicted.
+    bool pinned_;
 };
 
 /// Ture type font face description.
@@ -125,8 +145,18 @@ public:
     virtual bool Load(const unsigned char* fontData, unsigned fontDataSize);
     /// Return pointer to the glyph structure corresponding to a character. Return null if glyph not found.
     virtual const FontGlyph* GetGlyph(unsigned c) const;
+    /// Return pointer to the glyph structure corresponding to a character for measuring only. The glyph is not rendered to the texture and its texture position is not valid. The pointer is valid until the next glyph query of the face. Return null if glyph not found.
+    virtual const FontGlyph* GetGlyphMetrics(unsigned c) const;
+
+    /// Release the glyphs pinned by a worker thread build.
+    void ReleasePinnedGlyphs();
 
 private:
+    /// Render a glyph to the least recently used texture slot that is not pinned. Return null if no slot is available. Call from the main thread only.
+    const FontGlyph* RenderGlyph(unsigned c) const;
+    /// Pin a glyph read by a worker thread build. Called with the glyph mutex locked.
+    void PinGlyph(MutableFontGlyph* glyph) const;
+
     /// Calculate texture size.
     bool CalculateTextureSize(int &texWidth, int &texHeight);
     /// Create font face texture from data.
@@ -142,6 +172,14 @@ private:
     mutable List<MutableFontGlyph*> mutableGlyphList;
     /// Mutable glyph mapping.
     mutable HashMap<unsigned, MutableFontGlyph*> mutableGlyphMapping_;
+    /// Metrics of glyphs that have been measured but not rendered. Entries are removed when the glyph is rendered, and all are cleared when the count reaches a limit.
+    mutable HashMap<unsigned, FontGlyph> glyphMetrics_;
+    /// Glyphs pinned by a worker thread build.
+    mutable PODVector<MutableFontGlyph*> pinnedGlyphs_;
+    /// Bitmap buffer for rendering a glyph.
+    mutable SharedArrayPtr<unsigned char> glyphData_;
+    /// Mutex for glyph access from the main thread and a worker thread.
+    mutable Mutex glyphMutex_;
 };
 
 /// Bitmap font face description.
@@ -175,8 +213,10 @@ public:
     static void RegisterObject(Context* context);
     /// Load resource. Return true if successful.
     virtual bool Load(Deserializer& source);
-    /// Return font face. Pack and render to a texture if not rendered yet. Return null on error.
+    /// Return font face. Pack and render to a texture if not rendered yet. Return null on error. From a worker thread only existing faces are returned.
     const FontFace* GetFace(int pointSize);
+    /// Return created font faces by point size. Call from the main thread.
+    const HashMap<int, SharedPtr<FontFace> >& GetFaces() const { return faces_; }
 
 private:
     /// Return True-type font face. Called internally. Return null on error.
@@ -192,6 +232,8 @@ private:
     unsigned fontDataSize_;
     /// Font type.
     FONT_TYPE fontType_;
+    /// Mutex for face lookup from a worker thread.
+    Mutex facesMutex_;
 };
 
 }
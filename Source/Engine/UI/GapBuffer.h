@@ -0,0 +1,128 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "MathDefs.h"
+#include "Vector.h"
+
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// Array of plain data with a movable gap. Inserting and erasing near the previous edit only moves the elements in between, so typing into long text is constant time.
+template <class T> class GapBuffer
+{
+public:
+    /// Construct empty.
+    GapBuffer() :
+        gapStart_(0),
+        gapEnd_(0)
+    {
+    }
+
+    /// Set the contents.
+    void Assign(const T* data, unsigned count)
+    {
+        buffer_.Resize(count);
+        if (count)
+            memcpy(buffer_.Buffer(), data, count * sizeof(T));
+        gapStart_ = gapEnd_ = count;
+    }
+
+    /// Replace a range with new elements. Erasing widens the gap and inserting fills it from the start.
+    void Replace(unsigned position, unsigned length, const T* data, unsigned count)
+    {
+        MoveGap(position);
+        gapEnd_ += length;
+        ReserveGap(count);
+        if (count)
+            memcpy(buffer_.Buffer() + gapStart_, data, count * sizeof(T));
+        gapStart_ += count;
+    }
+
+    /// Remove all elements.
+    void Clear()
+    {
+        buffer_.Clear();
+        gapStart_ = gapEnd_ = 0;
+    }
+
+    /// Return element at index.
+    T& operator [] (unsigned index) { return index < gapStart_ ? buffer_[index] : buffer_[index + gapEnd_ - gapStart_]; }
+    /// Return const element at index.
+    const T& operator [] (unsigned index) const { return index < gapStart_ ? buffer_[index] : buffer_[index + gapEnd_ - gapStart_]; }
+    /// Return number of elements.
+    unsigned Size() const { return buffer_.Size() - (gapEnd_ - gapStart_); }
+    /// Return whether has no elements.
+    bool Empty() const { return Size() == 0; }
+
+private:
+    /// Move the gap to an element position.
+    void MoveGap(unsigned position)
+    {
+        T* buffer = buffer_.Buffer();
+
+        if (position < gapStart_)
+        {
+            unsigned count = gapStart_ - position;
+            memmove(buffer + gapEnd_ - count, buffer + position, count * sizeof(T));
+            gapStart_ -= count;
+            gapEnd_ -= count;
+        }
+        else if (position > gapStart_)
+        {
+            unsigned count = position - gapStart_;
+            memmove(buffer + gapStart_, buffer + gapEnd_, count * sizeof(T));
+            gapStart_ += count;
+            gapEnd_ += count;
+        }
+    }
+
+    /// Make the gap at least the given size.
+    void ReserveGap(unsigned size)
+    {
+        unsigned gapSize = gapEnd_ - gapStart_;
+        if (gapSize >= size)
+            return;
+
+        // Grow in proportion to the contents so that typing does not reallocate on every keystroke
+        unsigned tailSize = buffer_.Size() - gapEnd_;
+        unsigned newGapSize = Max((int)size, Max(64, (int)(Size() / 2)));
+        buffer_.Resize(gapStart_ + newGapSize + tailSize);
+
+        T* buffer = buffer_.Buffer();
+        if (tailSize)
+            memmove(buffer + gapStart_ + newGapSize, buffer + gapEnd_, tailSize * sizeof(T));
+        gapEnd_ = gapStart_ + newGapSize;
+    }
+
+    /// Elements with the gap.
+    PODVector<T> buffer_;
+    /// Gap start.
+    unsigned gapStart_;
+    /// Gap end, exclusive.
+    unsigned gapEnd_;
+};
+
+}
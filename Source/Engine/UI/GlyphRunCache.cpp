@@ -0,0 +1,155 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "Font.h"
+#include "GlyphRunCache.h"
+#include "Texture2D.h"
+#include "UIElement.h"
+#include "UIQuads.h"
+
+#include <cstring>
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+GlyphRunCache::GlyphRunCache() :
+    generation_(0),
+    opacity_(1.0f),
+    numGlyphs_(0),
+    complete_(false)
+{
+}
+
+GlyphRunCache::~GlyphRunCache()
+{
+}
+
+void GlyphRunCache::Build(UIElement* element, const FontFace* face, const unsigned* text, const IntVector2* positions, unsigned numChars, const Color& color)
+{
+    Clear();
+    if (!element || !face)
+        return;
+
+    // Take the generation before rendering the glyphs, so that evictions caused by this build also invalidate it
+    face_ = const_cast<FontFace*>(face);
+    generation_ = face->generation_;
+    color_ = color;
+    opacity_ = element->GetDerivedOpacity();
+    buildPosition_ = element->GetScreenPosition();
+    complete_ = true;
+
+    glyphs_.Resize(numChars);
+    for (unsigned i = 0; i < numChars; ++i)
+    {
+        glyphs_[i] = face->GetGlyph(text[i]);
+
+        // A glyph the font has may be unavailable on a worker thread. Do not keep quads without it
+        if (!glyphs_[i] && face->GetGlyphMetrics(text[i]))
+            complete_ = false;
+    }
+
+    // Write the quads of each font texture in bulk. Positions, texture coordinates and color are computed as in
+    // UIBatch::AddQuad(), so that the vertices match those of uncached text exactly
+    const IntVector2& screenPos = element->GetScreenPosition();
+    pageVertices_.Resize(face->textures_.Size());
+    for (unsigned page = 0; page < face->textures_.Size(); ++page)
+    {
+        UIBatch batch(element, BLEND_ALPHA, IntRect::ZERO, face->textures_[page], &pageVertices_[page]);
+        batch.SetColor(color);
+
+        quadRects_.Clear();
+        quadUVs_.Clear();
+        for (unsigned i = 0; i < numChars; ++i)
+        {
+            const FontGlyph* glyph = glyphs_[i];
+            if (!glyph || glyph->page_ != page || !glyph->width_ || !glyph->height_)
+                continue;
+
+            float left = (float)(positions[i].x_ + glyph->offsetX_ + screenPos.x_) - UIBatch::posAdjust.x_;
+            float top = (float)(positions[i].y_ + glyph->offsetY_ + screenPos.y_) - UIBatch::posAdjust.y_;
+            quadRects_.Push(left);
+            quadRects_.Push(top);
+            quadRects_.Push(left + (float)glyph->width_);
+            quadRects_.Push(top + (float)glyph->height_);
+            quadUVs_.Push(glyph->x_ * batch.invTextureSize_.x_);
+            quadUVs_.Push(glyph->y_ * batch.invTextureSize_.y_);
+            quadUVs_.Push((glyph->x_ + glyph->width_) * batch.invTextureSize_.x_);
+            quadUVs_.Push((glyph->y_ + glyph->height_) * batch.invTextureSize_.y_);
+            ++numGlyphs_;
+        }
+
+        // If alpha is 0, nothing will be rendered, so do not add the quads
+        unsigned numQuads = quadRects_.Size() / 4;
+        if (!numQuads || !(batch.color_ & 0xff000000))
+            continue;
+
+        PODVector<float>& vertices = pageVertices_[page];
+        vertices.Resize(numQuads * 6 * UI_VERTEX_SIZE);
+        WriteQuads(&vertices[0], &quadRects_[0], &quadUVs_[0], numQuads, batch.color_);
+    }
+}
+
+void GlyphRunCache::Clear()
+{
+    pageVertices_.Clear();
+    face_.Reset();
+    numGlyphs_ = 0;
+}
+
+void GlyphRunCache::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, UIElement* element, const IntRect& currentScissor,
+    const IntVector2& offset) const
+{
+    if (!face_ || !numGlyphs_)
+        return;
+
+    IntVector2 delta = element->GetScreenPosition() + offset - buildPosition_;
+
+    for (unsigned page = 0; page < pageVertices_.Size() && page < face_->textures_.Size(); ++page)
+    {
+        const PODVector<float>& src = pageVertices_[page];
+        if (src.Empty())
+            continue;
+
+        UIBatch batch(element, BLEND_ALPHA, currentScissor, face_->textures_[page], &vertexData);
+        unsigned start = vertexData.Size();
+        vertexData.Resize(start + src.Size());
+        if (delta == IntVector2::ZERO)
+            memcpy(&vertexData[start], &src[0], src.Size() * sizeof(float));
+        else
+            TranslateVertices(&vertexData[start], &src[0], src.Size() / UI_VERTEX_SIZE, Vector2((float)delta.x_, (float)delta.y_));
+        batch.vertexStart_ = start;
+        batch.vertexEnd_ = vertexData.Size();
+
+        UIBatch::AddOrMerge(batch, batches);
+    }
+}
+
+bool GlyphRunCache::IsValid(UIElement* element, const FontFace* face, const Color& color) const
+{
+    return face_ && complete_ && face == face_ && face->generation_ == generation_ && !face->IsDataLost() && color == color_ &&
+        element->GetDerivedOpacity() == opacity_;
+}
+
+}
@@ -0,0 +1,81 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Color.h"
+#include "Ptr.h"
+#include "UIBatch.h"
+
+namespace Urho3D
+{
+
+class FontFace;
+class UIElement;
+
+/// Laid out glyph quads of a text, cached relative to the element's screen position and grouped by font texture. Generating batches from a valid cache only translates the vertices, so texts that move but do not change skip glyph lookup, kerning and quad generation.
+class URHO3D_API GlyphRunCache
+{
+public:
+    /// Construct.
+    GlyphRunCache();
+    /// Destruct.
+    ~GlyphRunCache();
+
+    /// Build the glyph quads of characters at positions relative to the element. Glyphs are rendered to the font textures if necessary.
+    void Build(UIElement* element, const FontFace* face, const unsigned* text, const IntVector2* positions, unsigned numChars, const Color& color);
+    /// Clear the cached quads.
+    void Clear();
+    /// Generate batches by translating the cached quads to the element's current screen position plus an offset.
+    void GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, UIElement* element, const IntRect& currentScissor, const IntVector2& offset = IntVector2::ZERO) const;
+
+    /// Return whether the cache can be used for an element, font face and color. Evicting glyphs from the font textures, or a change of the element's opacity, invalidates the cache.
+    bool IsValid(UIElement* element, const FontFace* face, const Color& color) const;
+    /// Return number of cached glyph quads.
+    unsigned GetNumGlyphs() const { return numGlyphs_; }
+
+private:
+    /// Vertices by font texture.
+    Vector<PODVector<float> > pageVertices_;
+    /// Glyphs of the characters during a build.
+    PODVector<const FontGlyph*> glyphs_;
+    /// Quad positions as left, top, right, bottom during a build.
+    PODVector<float> quadRects_;
+    /// Quad texture coordinates as left, top, right, bottom during a build.
+    PODVector<float> quadUVs_;
+    /// Font face. Owned by the font, which may release it, for example when reloaded.
+    WeakPtr<FontFace> face_;
+    /// Glyph generation of the font face at build time.
+    unsigned generation_;
+    /// Color.
+    Color color_;
+    /// Derived opacity of the element at build time.
+    float opacity_;
+    /// Screen position of the element at build time.
+    IntVector2 buildPosition_;
+    /// Number of glyph quads.
+    unsigned numGlyphs_;
+    /// Whether all glyphs were available at build time.
+    bool complete_;
+};
+
+}
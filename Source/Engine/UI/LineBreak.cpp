@@ -0,0 +1,431 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "LineBreak.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Character range with a line break class.
+struct LineBreakRange
+{
+    unsigned first_;
+    unsigned last_;
+    unsigned char class_;
+};
+
+static const unsigned char DIR = 0;    // Direct break
+static const unsigned char IND = 1;    // Break only when spaces in between
+static const unsigned char PRO = 2;    // No break, even when spaces in between
+
+// Pair table from UAX #14, indexed by the class before and after the break, reduced to the classes of LineBreakClass
+static const unsigned char pairTable[LBC_ID + 1][LBC_ID + 1] =
+{
+    //  OP   CL   QU   GL   NS   EX   IS   NU   PR   PO   HY   BA   AL   ID
+    { PRO, PRO, PRO, PRO, PRO, PRO, PRO, PRO, PRO, PRO, PRO, PRO, PRO, PRO }, // OP
+    { DIR, PRO, IND, IND, PRO, PRO, PRO, DIR, IND, IND, IND, IND, DIR, DIR }, // CL
+    { PRO, PRO, IND, IND, IND, PRO, PRO, IND, IND, IND, IND, IND, IND, IND }, // QU
+    { IND, PRO, IND, IND, IND, PRO, PRO, IND, IND, IND, IND, IND, IND, IND }, // GL
+    { DIR, PRO, IND, IND, IND, PRO, PRO, DIR, DIR, DIR, IND, IND, DIR, DIR }, // NS
+    { DIR, PRO, IND, IND, IND, PRO, PRO, DIR, DIR, DIR, IND, IND, DIR, DIR }, // EX
+    { DIR, PRO, IND, IND, IND, PRO, PRO, IND, DIR, DIR, IND, IND, IND, DIR }, // IS
+    { IND, PRO, IND, IND, IND, PRO, PRO, IND, IND, IND, IND, IND, IND, DIR }, // NU
+    { IND, PRO, IND, IND, IND, PRO, PRO, IND, DIR, DIR, IND, IND, IND, IND }, // PR
+    { IND, PRO, IND, IND, IND, PRO, PRO, IND, DIR, DIR, IND, IND, IND, DIR }, // PO
+    { DIR, PRO, IND, DIR, IND, PRO, PRO, IND, DIR, DIR, IND, IND, DIR, DIR }, // HY
+    { DIR, PRO, IND, DIR, IND, PRO, PRO, DIR, DIR, DIR, IND, IND, DIR, DIR }, // BA
+    { IND, PRO, IND, IND, IND, PRO, PRO, IND, IND, IND, IND, IND, IND, DIR }, // AL
+    { DIR, PRO, IND, IND, IND, PRO, PRO, DIR, DIR, IND, IND, IND, DIR, DIR }  // ID
+};
+
+// Classes of the ASCII characters
+static const unsigned char asciiClasses[128] =
+{
+    LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, // 0x00
+    LBC_AL, LBC_BA, LBC_BK, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, // 0x08 tab, newline
+    LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, // 0x10
+    LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, // 0x18
+    LBC_SP, LBC_EX, LBC_QU, LBC_AL, LBC_PR, LBC_PO, LBC_AL, LBC_QU, // 0x20  !"#$%&'
+    LBC_OP, LBC_CL, LBC_AL, LBC_PR, LBC_IS, LBC_HY, LBC_IS, LBC_IS, // 0x28 ()*+,-./
+    LBC_NU, LBC_NU, LBC_NU, LBC_NU, LBC_NU, LBC_NU, LBC_NU, LBC_NU, // 0x30 0-7
+    LBC_NU, LBC_NU, LBC_IS, LBC_IS, LBC_AL, LBC_AL, LBC_AL, LBC_EX, // 0x38 89:;<=>?
+    LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, // 0x40
+    LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, // 0x48
+    LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, // 0x50
+    LBC_AL, LBC_AL, LBC_AL, LBC_OP, LBC_PR, LBC_CL, LBC_AL, LBC_AL, // 0x58 [\]
+    LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, // 0x60
+    LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, // 0x68
+    LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, LBC_AL, // 0x70
+    LBC_AL, LBC_AL, LBC_AL, LBC_OP, LBC_BA, LBC_CL, LBC_AL, LBC_AL  // 0x78 {|}
+};
+
+// Non-ASCII characters that are not plain alphabetic or ideographic, sorted. Includes the kinsoku characters
+static const LineBreakRange specialRanges[] =
+{
+    { 0x00a0, 0x00a0, LBC_GL }, { 0x00a1, 0x00a1, LBC_OP }, { 0x00a2, 0x00a2, LBC_PO }, { 0x00a3, 0x00a5, LBC_PR },
+    { 0x00ab, 0x00ab, LBC_QU }, { 0x00ad, 0x00ad, LBC_BA }, { 0x00b0, 0x00b0, LBC_PO }, { 0x00b1, 0x00b1, LBC_PR },
+    { 0x00bb, 0x00bb, LBC_QU }, { 0x00bf, 0x00bf, LBC_OP },
+    { 0x2000, 0x2006, LBC_BA }, { 0x2007, 0x2007, LBC_GL }, { 0x2008, 0x200a, LBC_BA }, { 0x200b, 0x200b, LBC_ZW },
+    { 0x2010, 0x2010, LBC_BA }, { 0x2011, 0x2011, LBC_GL }, { 0x2012, 0x2014, LBC_BA }, { 0x2018, 0x2019, LBC_QU },
+    { 0x201c, 0x201d, LBC_QU }, { 0x2024, 0x2026, LBC_NS }, { 0x2030, 0x2037, LBC_PO }, { 0x2039, 0x203a, LBC_QU },
+    { 0x203c, 0x203d, LBC_NS }, { 0x2047, 0x2049, LBC_NS }, { 0x2060, 0x2060, LBC_GL }, { 0x20a0, 0x20cf, LBC_PR },
+    { 0x2103, 0x2103, LBC_PO }, { 0x2116, 0x2116, LBC_PR },
+    { 0x3000, 0x3000, LBC_BA }, { 0x3001, 0x3002, LBC_CL }, { 0x3005, 0x3005, LBC_NS }, { 0x3008, 0x3008, LBC_OP },
+    { 0x3009, 0x3009, LBC_CL }, { 0x300a, 0x300a, LBC_OP }, { 0x300b, 0x300b, LBC_CL }, { 0x300c, 0x300c, LBC_OP },
+    { 0x300d, 0x300d, LBC_CL }, { 0x300e, 0x300e, LBC_OP }, { 0x300f, 0x300f, LBC_CL }, { 0x3010, 0x3010, LBC_OP },
+    { 0x3011, 0x3011, LBC_CL }, { 0x3014, 0x3014, LBC_OP }, { 0x3015, 0x3015, LBC_CL }, { 0x3016, 0x3016, LBC_OP },
+    { 0x3017, 0x3017, LBC_CL }, { 0x3018, 0x3018, LBC_OP }, { 0x3019, 0x3019, LBC_CL }, { 0x301a, 0x301a, LBC_OP },
+    { 0x301b, 0x301b, LBC_CL }, { 0x301c, 0x301c, LBC_NS }, { 0x301d, 0x301d, LBC_OP }, { 0x301e, 0x301f, LBC_CL },
+    { 0x303b, 0x303c, LBC_NS }, { 0x3041, 0x3041, LBC_NS }, { 0x3043, 0x3043, LBC_NS }, { 0x3045, 0x3045, LBC_NS },
+    { 0x3047, 0x3047, LBC_NS }, { 0x3049, 0x3049, LBC_NS }, { 0x3063, 0x3063, LBC_NS }, { 0x3083, 0x3083, LBC_NS },
+    { 0x3085, 0x3085, LBC_NS }, { 0x3087, 0x3087, LBC_NS }, { 0x308e, 0x308e, LBC_NS }, { 0x3095, 0x3096, LBC_NS },
+    { 0x309b, 0x309e, LBC_NS }, { 0x30a0, 0x30a1, LBC_NS }, { 0x30a3, 0x30a3, LBC_NS }, { 0x30a5, 0x30a5, LBC_NS },
+    { 0x30a7, 0x30a7, LBC_NS }, { 0x30a9, 0x30a9, LBC_NS }, { 0x30c3, 0x30c3, LBC_NS }, { 0x30e3, 0x30e3, LBC_NS },
+    { 0x30e5, 0x30e5, LBC_NS }, { 0x30e7, 0x30e7, LBC_NS }, { 0x30ee, 0x30ee, LBC_NS }, { 0x30f5, 0x30f6, LBC_NS },
+    { 0x30fb, 0x30fe, LBC_NS }, { 0x31f0, 0x31ff, LBC_NS },
+    { 0xfe50, 0xfe50, LBC_CL }, { 0xfe51, 0xfe51, LBC_CL }, { 0xfe52, 0xfe52, LBC_CL }, { 0xfe54, 0xfe55, LBC_NS },
+    { 0xfe56, 0xfe57, LBC_EX }, { 0xfe59, 0xfe59, LBC_OP }, { 0xfe5a, 0xfe5a, LBC_CL }, { 0xfe5b, 0xfe5b, LBC_OP },
+    { 0xfe5c, 0xfe5c, LBC_CL }, { 0xfe5d, 0xfe5d, LBC_OP }, { 0xfe5e, 0xfe5e, LBC_CL }, { 0xfeff, 0xfeff, LBC_GL },
+    { 0xff01, 0xff01, LBC_EX }, { 0xff04, 0xff04, LBC_PR }, { 0xff05, 0xff05, LBC_PO }, { 0xff08, 0xff08, LBC_OP },
+    { 0xff09, 0xff09, LBC_CL }, { 0xff0c, 0xff0c, LBC_CL }, { 0xff0e, 0xff0e, LBC_CL }, { 0xff1a, 0xff1b, LBC_NS },
+    { 0xff1f, 0xff1f, LBC_EX }, { 0xff3b, 0xff3b, LBC_OP }, { 0xff3d, 0xff3d, LBC_CL }, { 0xff5b, 0xff5b, LBC_OP },
+    { 0xff5d, 0xff5d, LBC_CL }, { 0xff5f, 0xff5f, LBC_OP }, { 0xff60, 0xff61, LBC_CL }, { 0xff62, 0xff62, LBC_OP },
+    { 0xff63, 0xff64, LBC_CL }, { 0xff65, 0xff65, LBC_NS }, { 0xff67, 0xff70, LBC_NS }, { 0xff9e, 0xff9f, LBC_NS },
+    { 0xffe0, 0xffe0, LBC_PO }, { 0xffe1, 0xffe1, LBC_PR }, { 0xffe5, 0xffe6, LBC_PR }
+};
+
+// Ideographic ranges: CJK radicals, punctuation, kana, ideographs, Hangul syllables, fullwidth forms and the supplementary planes
+static const LineBreakRange ideographicRanges[] =
+{
+    { 0x1100, 0x115f, LBC_ID }, { 0x2e80, 0x2fff, LBC_ID }, { 0x3003, 0x303f, LBC_ID }, { 0x3040, 0x31ef, LBC_ID },
+    { 0x3200, 0x4dbf, LBC_ID }, { 0x4e00, 0x9fff, LBC_ID }, { 0xa000, 0xa4cf, LBC_ID }, { 0xac00, 0xd7a3, LBC_ID },
+    { 0xf900, 0xfaff, LBC_ID }, { 0xfe30, 0xfe4f, LBC_ID }, { 0xff00, 0xff60, LBC_ID }, { 0xffe0, 0xffe6, LBC_ID },
+    { 0x20000, 0x2fffd, LBC_ID }, { 0x30000, 0x3fffd, LBC_ID }
+};
+
+static const LineBreakRange* FindRange(const LineBreakRange* ranges, unsigned numRanges, unsigned c)
+{
+    unsigned low = 0;
+    unsigned high = numRanges;
+    while (low < high)
+    {
+        unsigned mid = (low + high) >> 1;
+        if (c < ranges[mid].first_)
+            high = mid;
+        else if (c > ranges[mid].last_)
+            low = mid + 1;
+        else
+            return &ranges[mid];
+    }
+
+    return 0;
+}
+
+LineBreakClass GetLineBreakClass(unsigned c)
+{
+    if (c < 128)
+        return (LineBreakClass)asciiClasses[c];
+
+    const LineBreakRange* range = FindRange(specialRanges, sizeof(specialRanges) / sizeof(LineBreakRange), c);
+    if (range)
+        return (LineBreakClass)range->class_;
+
+    range = FindRange(ideographicRanges, sizeof(ideographicRanges) / sizeof(LineBreakRange), c);
+    if (range)
+        return LBC_ID;
+
+    return LBC_AL;
+}
+
+/// Find the line break opportunities of a range. The text and breaks are either arrays or gap buffers.
+template <class TextType, class BreaksType> static void FindBreaks(const TextType& text, unsigned length, BreaksType& breaks,
+    unsigned start, unsigned end)
+{
+    if (end > length)
+        end = length;
+    if (start >= end)
+        return;
+
+    // Resume the state from before the start: the last class that was not a space, whether spaces followed it, and
+    // whether it was a newline
+    LineBreakClass before = LBC_BK;
+    bool spaces = false;
+    bool newline = false;
+    bool rowStart = true;
+    unsigned i = start;
+    while (i > 0)
+    {
+        LineBreakClass c = GetLineBreakClass(text[--i]);
+        if (c == LBC_SP)
+            spaces = true;
+        else
+        {
+            before = c;
+            newline = c == LBC_BK && !spaces;
+            rowStart = c == LBC_BK;
+            break;
+        }
+    }
+
+    for (i = start; i < end; ++i)
+    {
+        LineBreakClass after = GetLineBreakClass(text[i]);
+
+        if (newline)
+            breaks[i] = LB_MANDATORY;
+        // No break after spaces at the start of the text or a row
+        else if (rowStart || after == LBC_SP || after == LBC_BK)
+            breaks[i] = LB_NONE;
+        else if (before == LBC_ZW || after == LBC_ZW)
+            breaks[i] = (unsigned char)(before == LBC_ZW ? LB_ALLOWED : LB_NONE);
+        else
+        {
+            unsigned char action = pairTable[before][after];
+            breaks[i] = (unsigned char)((action == DIR || (action == IND && spaces)) ? LB_ALLOWED : LB_NONE);
+        }
+
+        newline = after == LBC_BK;
+        if (after == LBC_SP)
+            spaces = true;
+        else
+        {
+            before = after;
+            spaces = false;
+            rowStart = newline;
+        }
+    }
+}
+
+void FindLineBreaks(const unsigned* text, unsigned length, unsigned char* breaks, unsigned start, unsigned end)
+{
+    FindBreaks(text, length, breaks, start, end);
+}
+
+LineBreaker::LineBreaker() :
+    maxWidth_(0),
+    numRowsWrapped_(0)
+{
+}
+
+void LineBreaker::SetText(const PODVector<unsigned>& text, const PODVector<int>& advances)
+{
+    PODVector<int> textAdvances = advances;
+    textAdvances.Resize(text.Size());
+    PODVector<unsigned char> textBreaks;
+    textBreaks.Resize(text.Size());
+
+    text_.Assign(text.Buffer(), text.Size());
+    advances_.Assign(textAdvances.Buffer(), textAdvances.Size());
+    breaks_.Assign(textBreaks.Buffer(), textBreaks.Size());
+    FindBreaks(text_, text_.Size(), breaks_, 0, text_.Size());
+
+    rowStarts_.Clear();
+    rowWidths_.Clear();
+    rowScanEnds_.Clear();
+    Wrap(0, false, 0, 0);
+}
+
+void LineBreaker::Replace(unsigned start, unsigned length, const PODVector<unsigned>& text, const PODVector<int>& advances)
+{
+    if (start > text_.Size())
+        start = text_.Size();
+    if (start + length > text_.Size())
+        length = text_.Size() - start;
+
+    unsigned numInserted = text.Size();
+    PODVector<int> insertedAdvances = advances;
+    insertedAdvances.Resize(numInserted);
+    PODVector<unsigned char> insertedBreaks;
+    insertedBreaks.Resize(numInserted);
+
+    // Each gap buffer moves its gap to the edit, so only the characters between this and the previous edit are moved
+    text_.Replace(start, length, text.Buffer(), numInserted);
+    advances_.Replace(start, length, insertedAdvances.Buffer(), numInserted);
+    breaks_.Replace(start, length, insertedBreaks.Buffer(), numInserted);
+
+    // Break opportunities change inside the edit, and after it up to and including the first character that does not
+    // follow a space
+    unsigned editEnd = start + numInserted;
+    unsigned breaksEnd = editEnd;
+    while (breaksEnd < text_.Size() && (breaksEnd == editEnd || GetLineBreakClass(text_[breaksEnd - 1]) == LBC_SP))
+        ++breaksEnd;
+    if (breaksEnd < text_.Size())
+        ++breaksEnd;
+    // Breaks after that have moved along with the text, so only the edited range needs to be classified again
+    FindBreaks(text_, text_.Size(), breaks_, start, breaksEnd);
+
+    // Rewrap from the first row whose wrapping decision looked at the edited text. Usually this is the edited row or
+    // the one before it, which may now absorb text from the edited row
+    unsigned row = GetRow(start);
+    while (row > 0 && rowScanEnds_[row - 1] >= start)
+        --row;
+    Wrap(row, true, breaksEnd, (int)numInserted - (int)length);
+}
+
+void LineBreaker::SetMaxWidth(int width)
+{
+    if (width == maxWidth_)
+        return;
+
+    maxWidth_ = width;
+    rowStarts_.Clear();
+    rowWidths_.Clear();
+    rowScanEnds_.Clear();
+    Wrap(0, false, 0, 0);
+}
+
+unsigned LineBreaker::GetRow(unsigned index) const
+{
+    if (rowStarts_.Empty())
+        return 0;
+
+    // Binary search for the last row starting at or before the index
+    unsigned low = 0;
+    unsigned high = rowStarts_.Size();
+    while (high - low > 1)
+    {
+        unsigned mid = (low + high) >> 1;
+        if (rowStarts_[mid] <= index)
+            low = mid;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+void LineBreaker::Wrap(unsigned fromRow, bool converge, unsigned changeEnd, int delta)
+{
+    if (fromRow > rowStarts_.Size())
+        fromRow = rowStarts_.Size();
+
+    oldRowStarts_.Clear();
+    oldRowWidths_.Clear();
+    oldRowScanEnds_.Clear();
+    if (converge)
+    {
+        for (unsigned i = fromRow; i < rowStarts_.Size(); ++i)
+        {
+            oldRowStarts_.Push(rowStarts_[i]);
+            oldRowWidths_.Push(rowWidths_[i]);
+            oldRowScanEnds_.Push(rowScanEnds_[i]);
+        }
+    }
+
+    unsigned pos = fromRow < rowStarts_.Size() ? rowStarts_[fromRow] : 0;
+    rowStarts_.Resize(fromRow);
+    rowWidths_.Resize(fromRow);
+    rowScanEnds_.Resize(fromRow);
+    numRowsWrapped_ = 0;
+
+    unsigned length = text_.Size();
+    unsigned oldIndex = 0;
+
+    for (;;)
+    {
+        // Stop when a row past the changed range starts at the same place as before: the remaining rows are unchanged
+        if (converge && pos >= changeEnd)
+        {
+            while (oldIndex < oldRowStarts_.Size() && (int)oldRowStarts_[oldIndex] + delta < (int)pos)
+                ++oldIndex;
+            if (oldIndex < oldRowStarts_.Size() && (int)oldRowStarts_[oldIndex] + delta == (int)pos)
+            {
+                for (unsigned i = oldIndex; i < oldRowStarts_.Size(); ++i)
+                {
+                    rowStarts_.Push(oldRowStarts_[i] + delta);
+                    rowWidths_.Push(oldRowWidths_[i]);
+                    rowScanEnds_.Push(oldRowScanEnds_[i] + delta);
+                }
+                return;
+            }
+        }
+
+        rowStarts_.Push(pos);
+        ++numRowsWrapped_;
+
+        int width = 0;
+        int rowWidth = 0;
+        unsigned lastBreak = pos;
+        int lastBreakWidth = 0;
+        unsigned i = pos;
+        unsigned scanEnd = length;
+
+        for (; i < length; ++i)
+        {
+            if (i > pos)
+            {
+                if (breaks_[i] == LB_MANDATORY)
+                {
+                    scanEnd = i;
+                    break;
+                }
+                if (breaks_[i] == LB_ALLOWED)
+                {
+                    lastBreak = i;
+                    lastBreakWidth = rowWidth;
+                }
+            }
+
+            unsigned c = text_[i];
+            if (c == '\n')
+                continue;
+
+            bool space = GetLineBreakClass(c) == LBC_SP;
+            // Spaces may hang past the row end, other characters move to the next row
+            if (maxWidth_ > 0 && !space && i > pos && width + advances_[i] > maxWidth_)
+            {
+                scanEnd = i;
+                if (lastBreak > pos)
+                {
+                    i = lastBreak;
+                    rowWidth = lastBreakWidth;
+                }
+                break;
+            }
+
+            width += advances_[i];
+            if (!space)
+                rowWidth = width;
+        }
+
+        rowWidths_.Push(rowWidth);
+        rowScanEnds_.Push(scanEnd);
+        if (i >= length)
+        {
+            // A newline at the end of the text begins an empty last row
+            if (length && text_[length - 1] == '\n' && pos < length)
+            {
+                rowStarts_.Push(length);
+                rowWidths_.Push(0);
+                rowScanEnds_.Push(length);
+                ++numRowsWrapped_;
+            }
+            break;
+        }
+        pos = i;
+    }
+}
+
+}
@@ -0,0 +1,133 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "GapBuffer.h"
+
+namespace Urho3D
+{
+
+/// Line break class of a character. A reduced set of the Unicode UAX #14 classes.
+enum LineBreakClass
+{
+    LBC_OP = 0,
+    LBC_CL,
+    LBC_QU,
+    LBC_GL,
+    LBC_NS,
+    LBC_EX,
+    LBC_IS,
+    LBC_NU,
+    LBC_PR,
+    LBC_PO,
+    LBC_HY,
+    LBC_BA,
+    LBC_AL,
+    LBC_ID,
+    LBC_SP,
+    LBC_BK,
+    LBC_ZW,
+    MAX_LINEBREAK_CLASSES
+};
+
+/// Line break opportunity before a character.
+enum LineBreakAction
+{
+    LB_NONE = 0,
+    LB_ALLOWED,
+    LB_MANDATORY
+};
+
+/// Return the line break class of a character.
+URHO3D_API LineBreakClass GetLineBreakClass(unsigned c);
+/// Find the line break opportunities before each character of a text in the range [start, end). The breaks vector must be as long as the text.
+URHO3D_API void FindLineBreaks(const unsigned* text, unsigned length, unsigned char* breaks, unsigned start, unsigned end);
+
+/// Greedy line breaker with CJK line break rules and incremental rewrap after edits. Keeps the characters, advances and break opportunities in gap buffers, so that edits near the previous one do not move the rest of the text.
+class URHO3D_API LineBreaker
+{
+public:
+    /// Construct.
+    LineBreaker();
+
+    /// Set the text as characters and their horizontal advances, and wrap it fully.
+    void SetText(const PODVector<unsigned>& text, const PODVector<int>& advances);
+    /// Replace a range of the text, then rewrap only the rows affected by the edit.
+    void Replace(unsigned start, unsigned length, const PODVector<unsigned>& text, const PODVector<int>& advances);
+    /// Set maximum row width. Zero or negative disables wrapping, so only newlines break rows.
+    void SetMaxWidth(int width);
+
+    /// Return number of characters.
+    unsigned GetLength() const { return text_.Size(); }
+    /// Return the character at an index.
+    unsigned GetCharacter(unsigned index) const { return text_[index]; }
+    /// Return the advance of the character at an index.
+    int GetAdvance(unsigned index) const { return advances_[index]; }
+    /// Return maximum row width.
+    int GetMaxWidth() const { return maxWidth_; }
+    /// Return number of rows.
+    unsigned GetNumRows() const { return rowStarts_.Size(); }
+    /// Return start character index of a row.
+    unsigned GetRowStart(unsigned row) const { return row < rowStarts_.Size() ? rowStarts_[row] : text_.Size(); }
+    /// Return end character index of a row, exclusive.
+    unsigned GetRowEnd(unsigned row) const { return row + 1 < rowStarts_.Size() ? rowStarts_[row + 1] : text_.Size(); }
+    /// Return width of a row, excluding trailing spaces.
+    int GetRowWidth(unsigned row) const { return row < rowWidths_.Size() ? rowWidths_[row] : 0; }
+    /// Return all row start indices.
+    const PODVector<unsigned>& GetRowStarts() const { return rowStarts_; }
+    /// Return all row widths.
+    const PODVector<int>& GetRowWidths() const { return rowWidths_; }
+    /// Return the row that contains a character index.
+    unsigned GetRow(unsigned index) const;
+    /// Return number of rows rewrapped by the last SetText(), Replace() or SetMaxWidth() call.
+    unsigned GetNumRowsWrapped() const { return numRowsWrapped_; }
+
+private:
+    /// Wrap rows starting from a row. When convergence is enabled, stop as soon as a row past the changed range starts at the same place as before the edit, shifted by delta.
+    void Wrap(unsigned fromRow, bool converge, unsigned changeEnd, int delta);
+
+    /// Characters.
+    GapBuffer<unsigned> text_;
+    /// Character advances.
+    GapBuffer<int> advances_;
+    /// Break opportunity before each character.
+    GapBuffer<unsigned char> breaks_;
+    /// Row start character indices.
+    PODVector<unsigned> rowStarts_;
+    /// Row widths.
+    PODVector<int> rowWidths_;
+    /// Last character index examined when wrapping each row.
+    PODVector<unsigned> rowScanEnds_;
+    /// Row start indices before the edit, used for convergence.
+    PODVector<unsigned> oldRowStarts_;
+    /// Row widths before the edit, used for convergence.
+    PODVector<int> oldRowWidths_;
+    /// Row scan ends before the edit, used for convergence.
+    PODVector<unsigned> oldRowScanEnds_;
+    /// Maximum row width.
+    int maxWidth_;
+    /// Number of rows wrapped by the last operation.
+    unsigned numRowsWrapped_;
+};
+
+}
@@ -0,0 +1,205 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "TextDecode.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DECODE_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DECODE_NEON
+#endif
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Decode one character starting with a non-ASCII byte. Advance the source pointer and return false if the sequence is invalid.
+static bool DecodeMultiByte(const unsigned char*& src, const unsigned char* end, unsigned& c)
+{
+    unsigned char lead = *src;
+    unsigned numTrail;
+    unsigned minValue;
+
+    if (lead >= 0xc2 && lead <= 0xdf)
+    {
+        numTrail = 1;
+        minValue = 0x80;
+        c = lead & 0x1f;
+    }
+    else if (lead >= 0xe0 && lead <= 0xef)
+    {
+        numTrail = 2;
+        minValue = 0x800;
+        c = lead & 0x0f;
+    }
+    else if (lead >= 0xf0 && lead <= 0xf4)
+    {
+        numTrail = 3;
+        minValue = 0x10000;
+        c = lead & 0x07;
+    }
+    else
+    {
+        // Stray continuation byte, overlong two-byte lead or out of range lead
+        ++src;
+        c = UTF8_REPLACEMENT_CHAR;
+        return false;
+    }
+
+    if ((unsigned)(end - src) <= numTrail)
+    {
+        ++src;
+        c = UTF8_REPLACEMENT_CHAR;
+        return false;
+    }
+
+    for (unsigned i = 1; i <= numTrail; ++i)
+    {
+        unsigned char trail = src[i];
+        if ((trail & 0xc0) != 0x80)
+        {
+            ++src;
+            c = UTF8_REPLACEMENT_CHAR;
+            return false;
+        }
+        c = (c << 6) | (trail & 0x3f);
+    }
+
+    if (c < minValue || c > 0x10ffff || (c >= 0xd800 && c <= 0xdfff))
+    {
+        ++src;
+        c = UTF8_REPLACEMENT_CHAR;
+        return false;
+    }
+
+    src += numTrail + 1;
+    return true;
+}
+
+bool DecodeUTF8(const char* src, unsigned length, PODVector<unsigned>& dest)
+{
+    #if defined(DECODE_SSE2) || defined(DECODE_NEON)
+    // A character takes at least one byte, so the length is an upper bound of the character count
+    dest.Resize(length);
+    if (!length)
+        return true;
+
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(src);
+    const unsigned char* end = in + length;
+    unsigned* out = dest.Buffer();
+    bool valid = true;
+
+    while (in < end)
+    {
+        // Widen ASCII 16 bytes at a time until a byte with the high bit set is found
+        while (end - in >= 16)
+        {
+            #if defined(DECODE_SSE2)
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+            if (_mm_movemask_epi8(bytes))
+                break;
+
+            const __m128i zero = _mm_setzero_si128();
+            __m128i low = _mm_unpacklo_epi8(bytes, zero);
+            __m128i high = _mm_unpackhi_epi8(bytes, zero);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi16(low, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_unpackhi_epi16(low, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpacklo_epi16(high, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm_unpackhi_epi16(high, zero));
+            #else
+            uint8x16_t bytes = vld1q_u8(in);
+            uint8x8_t highBits = vorr_u8(vget_low_u8(bytes), vget_high_u8(bytes));
+            if (vget_lane_u64(vreinterpret_u64_u8(highBits), 0) & 0x8080808080808080ULL)
+                break;
+
+            uint16x8_t low = vmovl_u8(vget_low_u8(bytes));
+            uint16x8_t high = vmovl_u8(vget_high_u8(bytes));
+            vst1q_u32(out, vmovl_u16(vget_low_u16(low)));
+            vst1q_u32(out + 4, vmovl_u16(vget_high_u16(low)));
+            vst1q_u32(out + 8, vmovl_u16(vget_low_u16(high)));
+            vst1q_u32(out + 12, vmovl_u16(vget_high_u16(high)));
+            #endif
+
+            in += 16;
+            out += 16;
+        }
+
+        if (in == end)
+            break;
+
+        // Decode one character with the scalar path: ASCII tail or a multi-byte sequence
+        if (*in < 0x80)
+            *out++ = *in++;
+        else
+        {
+            unsigned c;
+            if (!DecodeMultiByte(in, end, c))
+                valid = false;
+            *out++ = c;
+        }
+    }
+
+    dest.Resize((unsigned)(out - dest.Buffer()));
+    return valid;
+    #else
+    return DecodeUTF8Scalar(src, length, dest);
+    #endif
+}
+
+bool DecodeUTF8(const String& src, PODVector<unsigned>& dest)
+{
+    return DecodeUTF8(src.CString(), src.Length(), dest);
+}
+
+bool DecodeUTF8Scalar(const char* src, unsigned length, PODVector<unsigned>& dest)
+{
+    dest.Resize(length);
+    if (!length)
+        return true;
+
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(src);
+    const unsigned char* end = in + length;
+    unsigned* out = dest.Buffer();
+    bool valid = true;
+
+    while (in < end)
+    {
+        if (*in < 0x80)
+            *out++ = *in++;
+        else
+        {
+            unsigned c;
+            if (!DecodeMultiByte(in, end, c))
+                valid = false;
+            *out++ = c;
+        }
+    }
+
+    dest.Resize((unsigned)(out - dest.Buffer()));
+    return valid;
+}
+
+}
@@ -0,0 +1,41 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Str.h"
+#include "Vector.h"
+
+namespace Urho3D
+{
+
+/// Replacement character for invalid UTF-8 sequences.
+static const unsigned UTF8_REPLACEMENT_CHAR = 0xfffd;
+
+/// Decode UTF-8 text to characters, replacing the destination contents. Runs of ASCII are decoded with vector instructions when available. Invalid sequences, including overlong encodings, surrogates and truncated sequences, are replaced one byte at a time with the replacement character. Return true if the text was valid.
+URHO3D_API bool DecodeUTF8(const char* src, unsigned length, PODVector<unsigned>& dest);
+/// Decode a UTF-8 string to characters, replacing the destination contents. Return true if the string was valid.
+URHO3D_API bool DecodeUTF8(const String& src, PODVector<unsigned>& dest);
+/// Decode UTF-8 text to characters using the scalar code path only. Used as a reference for the vectorized path.
+URHO3D_API bool DecodeUTF8Scalar(const char* src, unsigned length, PODVector<unsigned>& dest);
+
+}
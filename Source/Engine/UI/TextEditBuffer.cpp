@@ -0,0 +1,281 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "Font.h"
+#include "TextDecode.h"
+#include "TextEditBuffer.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+TextEditBuffer::TextEditBuffer() :
+    fontSize_(0),
+    cursorPosition_(0),
+    selectionStart_(0),
+    selectionLength_(0)
+{
+    layout_.SetText(decodedText_, decodedAdvances_);
+}
+
+TextEditBuffer::~TextEditBuffer()
+{
+}
+
+void TextEditBuffer::SetText(const String& text)
+{
+    Decode(text);
+    layout_.SetText(decodedText_, decodedAdvances_);
+
+    cursorPosition_ = GetLength();
+    selectionStart_ = 0;
+    selectionLength_ = 0;
+}
+
+void TextEditBuffer::SetFont(Font* font, int size)
+{
+    if (font == font_.Get() && size == fontSize_)
+        return;
+
+    font_ = font;
+    fontSize_ = size;
+
+    // All advances change, so the whole text has to be rewrapped
+    const FontFace* face = GetFace();
+    unsigned length = GetLength();
+    decodedText_.Resize(length);
+    decodedAdvances_.Resize(length);
+    for (unsigned i = 0; i < length; ++i)
+    {
+        decodedText_[i] = GetCharacter(i);
+        decodedAdvances_[i] = GetAdvance(face, decodedText_[i]);
+    }
+    layout_.SetText(decodedText_, decodedAdvances_);
+}
+
+void TextEditBuffer::SetMaxWidth(int width)
+{
+    layout_.SetMaxWidth(width);
+}
+
+void TextEditBuffer::Insert(unsigned position, const String& text)
+{
+    Replace(position, 0, text);
+}
+
+void TextEditBuffer::Erase(unsigned position, unsigned length)
+{
+    Replace(position, length, String::EMPTY);
+}
+
+void TextEditBuffer::Replace(unsigned position, unsigned length, const String& text)
+{
+    unsigned oldLength = GetLength();
+    if (position > oldLength)
+        position = oldLength;
+    if (length > oldLength - position)
+        length = oldLength - position;
+
+    Decode(text);
+    unsigned numInserted = decodedText_.Size();
+    if (!length && !numInserted)
+        return;
+
+    layout_.Replace(position, length, decodedText_, decodedAdvances_);
+
+    unsigned selectionEnd = AdjustPosition(selectionStart_ + selectionLength_, position, length, numInserted);
+    selectionStart_ = AdjustPosition(selectionStart_, position, length, numInserted);
+    selectionLength_ = selectionEnd - selectionStart_;
+    cursorPosition_ = AdjustPosition(cursorPosition_, position, length, numInserted);
+}
+
+void TextEditBuffer::InsertAtCursor(const String& text)
+{
+    unsigned position = selectionLength_ ? selectionStart_ : cursorPosition_;
+    Replace(position, selectionLength_, text);
+    SetCursorPosition(position + decodedText_.Size());
+}
+
+void TextEditBuffer::DeleteBackward()
+{
+    if (selectionLength_)
+    {
+        unsigned position = selectionStart_;
+        Erase(position, selectionLength_);
+        SetCursorPosition(position);
+    }
+    else if (cursorPosition_)
+        Erase(cursorPosition_ - 1, 1);
+}
+
+void TextEditBuffer::DeleteForward()
+{
+    if (selectionLength_)
+    {
+        unsigned position = selectionStart_;
+        Erase(position, selectionLength_);
+        SetCursorPosition(position);
+    }
+    else if (cursorPosition_ < GetLength())
+        Erase(cursorPosition_, 1);
+}
+
+void TextEditBuffer::SetCursorPosition(unsigned position)
+{
+    cursorPosition_ = position < GetLength() ? position : GetLength();
+    ClearSelection();
+}
+
+void TextEditBuffer::SetSelection(unsigned start, unsigned length)
+{
+    unsigned textLength = GetLength();
+    if (start > textLength)
+        start = textLength;
+    if (length > textLength - start)
+        length = textLength - start;
+
+    selectionStart_ = start;
+    selectionLength_ = length;
+    cursorPosition_ = start + length;
+}
+
+void TextEditBuffer::ClearSelection()
+{
+    selectionStart_ = cursorPosition_;
+    selectionLength_ = 0;
+}
+
+String TextEditBuffer::GetText() const
+{
+    return GetSubstring(0, GetLength());
+}
+
+String TextEditBuffer::GetSubstring(unsigned start, unsigned length) const
+{
+    unsigned textLength = GetLength();
+    if (start > textLength)
+        start = textLength;
+    if (length > textLength - start)
+        length = textLength - start;
+
+    String ret;
+    ret.Reserve(length);
+    for (unsigned i = start; i < start + length; ++i)
+        ret.AppendUTF8(GetCharacter(i));
+    return ret;
+}
+
+int TextEditBuffer::GetRowHeight() const
+{
+    const FontFace* face = GetFace();
+    return face ? face->rowHeight_ : 1;
+}
+
+unsigned TextEditBuffer::GetIndex(unsigned row, unsigned column) const
+{
+    unsigned numRows = layout_.GetNumRows();
+    if (row >= numRows)
+        return GetLength();
+
+    unsigned start = layout_.GetRowStart(row);
+    unsigned end = layout_.GetRowEnd(row);
+    // Except on the last row, the row end already belongs to the next row
+    if (row + 1 < numRows && end > start)
+        --end;
+
+    return column < end - start ? start + column : end;
+}
+
+IntVector2 TextEditBuffer::GetCharPosition(unsigned index) const
+{
+    if (index > GetLength())
+        index = GetLength();
+
+    unsigned row = layout_.GetRow(index);
+    int x = 0;
+    for (unsigned i = layout_.GetRowStart(row); i < index; ++i)
+        x += layout_.GetAdvance(i);
+
+    return IntVector2(x, row * GetRowHeight());
+}
+
+unsigned TextEditBuffer::GetIndexAt(const IntVector2& position) const
+{
+    unsigned numRows = layout_.GetNumRows();
+    if (!numRows)
+        return 0;
+
+    int rowHeight = Max(GetRowHeight(), 1);
+    unsigned row = position.y_ > 0 ? Min(position.y_ / rowHeight, (int)numRows - 1) : 0;
+    unsigned end = GetIndex(row, M_MAX_UNSIGNED);
+
+    int x = 0;
+    for (unsigned i = layout_.GetRowStart(row); i < end; ++i)
+    {
+        int advance = layout_.GetAdvance(i);
+        if (position.x_ * 2 < x * 2 + advance)
+            return i;
+        x += advance;
+    }
+
+    return end;
+}
+
+void TextEditBuffer::Decode(const String& text)
+{
+    DecodeUTF8(text, decodedText_);
+
+    const FontFace* face = GetFace();
+    decodedAdvances_.Resize(decodedText_.Size());
+    for (unsigned i = 0; i < decodedText_.Size(); ++i)
+        decodedAdvances_[i] = GetAdvance(face, decodedText_[i]);
+}
+
+const FontFace* TextEditBuffer::GetFace() const
+{
+    return font_ ? font_->GetFace(fontSize_) : 0;
+}
+
+int TextEditBuffer::GetAdvance(const FontFace* face, unsigned c)
+{
+    if (c == '\n')
+        return 0;
+    if (!face)
+        return 1;
+
+    const FontGlyph* glyph = face->GetGlyphMetrics(c);
+    return glyph ? glyph->advanceX_ : 0;
+}
+
+unsigned TextEditBuffer::AdjustPosition(unsigned pos, unsigned position, unsigned length, unsigned numInserted)
+{
+    if (pos <= position)
+        return pos;
+    else if (pos >= position + length)
+        return pos - length + numInserted;
+    else
+        return position + numInserted;
+}
+
+}
@@ -0,0 +1,147 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "LineBreak.h"
+#include "Ptr.h"
+#include "Str.h"
+#include "Vector2.h"
+
+namespace Urho3D
+{
+
+class Font;
+class FontFace;
+
+/// Text editing buffer for line edits and multiline editors. The row layout keeps the characters in gap buffers so that edits at the cursor are constant time, and is kept up to date by rewrapping only the rows affected by each edit.
+class URHO3D_API TextEditBuffer
+{
+public:
+    /// Construct.
+    TextEditBuffer();
+    /// Destruct.
+    ~TextEditBuffer();
+
+    /// Set the whole text. Moves the cursor to the end and clears the selection.
+    void SetText(const String& text);
+    /// Set the font and size used to measure characters. Without a font every character is one unit wide.
+    void SetFont(Font* font, int size);
+    /// Set maximum row width. Zero or negative disables wrapping, so only newlines break rows.
+    void SetMaxWidth(int width);
+    /// Insert text at a character position.
+    void Insert(unsigned position, const String& text);
+    /// Erase characters.
+    void Erase(unsigned position, unsigned length);
+    /// Replace characters with text.
+    void Replace(unsigned position, unsigned length, const String& text);
+    /// Insert text at the cursor, replacing the selection if there is one.
+    void InsertAtCursor(const String& text);
+    /// Erase the selection, or the character before the cursor if nothing is selected.
+    void DeleteBackward();
+    /// Erase the selection, or the character after the cursor if nothing is selected.
+    void DeleteForward();
+    /// Set cursor character position. Clears the selection.
+    void SetCursorPosition(unsigned position);
+    /// Set selection. The cursor is moved to the selection end.
+    void SetSelection(unsigned start, unsigned length);
+    /// Clear the selection.
+    void ClearSelection();
+
+    /// Return number of characters.
+    unsigned GetLength() const { return layout_.GetLength(); }
+    /// Return the character at an index.
+    unsigned GetCharacter(unsigned index) const { return layout_.GetCharacter(index); }
+    /// Return the text as UTF-8.
+    String GetText() const;
+    /// Return a range of the text as UTF-8.
+    String GetSubstring(unsigned start, unsigned length) const;
+    /// Return the selected text as UTF-8.
+    String GetSelectedText() const { return GetSubstring(selectionStart_, selectionLength_); }
+    /// Return font.
+    Font* GetFont() const { return font_; }
+    /// Return font size.
+    int GetFontSize() const { return fontSize_; }
+    /// Return maximum row width.
+    int GetMaxWidth() const { return layout_.GetMaxWidth(); }
+    /// Return cursor character position.
+    unsigned GetCursorPosition() const { return cursorPosition_; }
+    /// Return selection start.
+    unsigned GetSelectionStart() const { return selectionStart_; }
+    /// Return selection length.
+    unsigned GetSelectionLength() const { return selectionLength_; }
+    /// Return number of rows.
+    unsigned GetNumRows() const { return layout_.GetNumRows(); }
+    /// Return start character index of a row.
+    unsigned GetRowStart(unsigned row) const { return layout_.GetRowStart(row); }
+    /// Return end character index of a row, exclusive.
+    unsigned GetRowEnd(unsigned row) const { return layout_.GetRowEnd(row); }
+    /// Return width of a row.
+    int GetRowWidth(unsigned row) const { return layout_.GetRowWidth(row); }
+    /// Return row height.
+    int GetRowHeight() const;
+    /// Return the row that contains a character index.
+    unsigned GetRow(unsigned index) const { return layout_.GetRow(index); }
+    /// Return the column of a character index within its row.
+    unsigned GetColumn(unsigned index) const { return index - layout_.GetRowStart(layout_.GetRow(index)); }
+    /// Return the row of the cursor.
+    unsigned GetCursorRow() const { return GetRow(cursorPosition_); }
+    /// Return the column of the cursor.
+    unsigned GetCursorColumn() const { return GetColumn(cursorPosition_); }
+    /// Return the character index at a row and column, clamped to the row.
+    unsigned GetIndex(unsigned row, unsigned column) const;
+    /// Return the position of a character index relative to the top left of the text.
+    IntVector2 GetCharPosition(unsigned index) const;
+    /// Return the character index closest to a position relative to the top left of the text.
+    unsigned GetIndexAt(const IntVector2& position) const;
+    /// Return the row layout.
+    const LineBreaker& GetLayout() const { return layout_; }
+
+private:
+    /// Decode UTF-8 text to characters and their advances.
+    void Decode(const String& text);
+    /// Return the font face of the font size, or null if no font. Looked up each time, as the font recreates its faces after their textures are lost.
+    const FontFace* GetFace() const;
+    /// Return the advance of a character in a font face.
+    static int GetAdvance(const FontFace* face, unsigned c);
+    /// Adjust a character position after an edit.
+    static unsigned AdjustPosition(unsigned pos, unsigned position, unsigned length, unsigned numInserted);
+
+    /// Row layout and characters.
+    LineBreaker layout_;
+    /// Font.
+    SharedPtr<Font> font_;
+    /// Font size.
+    int fontSize_;
+    /// Cursor character position.
+    unsigned cursorPosition_;
+    /// Selection start.
+    unsigned selectionStart_;
+    /// Selection length.
+    unsigned selectionLength_;
+    /// Decoded characters of the last inserted text.
+    PODVector<unsigned> decodedText_;
+    /// Advances of the last inserted text.
+    PODVector<int> decodedAdvances_;
+};
+
+}
@@ -30,6 +30,7 @@
 #include "Font.h"
 #include "Graphics.h"
 #include "GraphicsEvents.h"
+#include "Image.h"
 #include "Input.h"
 #include "InputEvents.h"
 #include "LineEdit.h"
@@ -38,6 +39,7 @@
 #include "Matrix3x4.h"
 #include "Profiler.h"
 #include "Renderer.h"
+#include "ResourceCache.h"
 #include "ScrollBar.h"
 #include "Shader.h"
 #include "ShaderVariation.h"
@@ -46,12 +48,20 @@
 #include "Sprite.h"
 #include "Text.h"
 #include "Text3D.h"
+#include "TextDecode.h"
+#include "TextEditBuffer.h"
 #include "Texture2D.h"
+#include "Timer.h"
 #include "UI.h"
+#include "UIAllocation.h"
+#include "UIAnimator.h"
+#include "UIElementIndex.h"
 #include "UIEvents.h"
+#include "UISoftwareRenderer.h"
 #include "VertexBuffer.h"
 #include "Window.h"
 #include "View3D.h"
+#include "WorkQueue.h"
 
 #include <SDL.h>
 
@@ -64,18 +74,84 @@ ShortStringHash VAR_ORIGIN("Origin");
 const ShortStringHash VAR_ORIGINAL_PARENT("OriginalParent");
 const ShortStringHash VAR_ORIGINAL_CHILD_INDEX("OriginalChildIndex");
 const ShortStringHash VAR_PARENT_CHANGED("ParentChanged");
+const ShortStringHash VAR_TEXTEDITBUFFER("TextEditBuffer");
 
 const float DEFAULT_DOUBLECLICK_INTERVAL = 0.5f;
+const int DEFAULT_COMPOSITION_FONT_SIZE = 12;
 
 const char* UI_CATEGORY = "UI";
 
+/// Work item priority of the pipelined batch build. Lowest, so that completing the renderer's work does not wait for it.
+static const unsigned UI_BATCH_BUILD_PRIORITY = 0;
+
+static void BuildUIBatchesWork(const WorkItem* item, unsigned threadIndex)
+{
+    UI* ui = static_cast<UI*>(item->aux_);
+    ui->BuildPendingBatches();
+}
+
+UIFrameStats::UIFrameStats()
+{
+    Reset();
+}
+
+void UIFrameStats::Reset()
+{
+    elementsVisited_ = 0;
+    batches_ = 0;
+    drawCalls_ = 0;
+    vertices_ = 0;
+    uploadedBytes_ = 0;
+    hitTests_ = 0;
+    eventsSent_ = 0;
+    glyphMisses_ = 0;
+    tasksRun_ = 0;
+    taskBacklog_ = 0;
+    taskTime_ = 0;
+    updateTime_ = 0;
+    renderUpdateTime_ = 0;
+    renderTime_ = 0;
+    updateAllocations_ = 0;
+    updateAllocatedBytes_ = 0;
+    renderUpdateAllocations_ = 0;
+    renderUpdateAllocatedBytes_ = 0;
+    renderAllocations_ = 0;
+    renderAllocatedBytes_ = 0;
+    inputAllocations_ = 0;
+    inputAllocatedBytes_ = 0;
+    glyphAllocations_ = 0;
+    glyphAllocatedBytes_ = 0;
+}
+
 UI::UI(Context* context) :
     Object(context),
     rootElement_(new UIElement(context)),
     rootModalElement_(new UIElement(context)),
+    buildNonModalBatchSize_(0),
+    buildTime_(0),
+    buildElementsVisited_(0),
+    buildCursorBatches_(true),
+    pipelinedBatching_(false),
+    batchBuildPending_(false),
+    batchBuildFinished_(false),
+    coalesceDragMoves_(true),
+    dragMovePending_(false),
+    dragMoveButtons_(0),
+    dragMoveQualifiers_(0),
+    hardwareCursorShape_(CS_NORMAL),
+    hardwareCursor_(false),
+    mouseVisibleBeforeHardwareCursor_(false),
+    compositionCursor_(0),
+    compositionPositionSet_(false),
+    compositionFontSize_(DEFAULT_COMPOSITION_FONT_SIZE),
+    compositionWidth_(0),
+    compositionCursorX_(0),
+    allocationCheck_(false),
+    allocationCheckFailures_(0),
+    buildAllocations_(0),
+    buildAllocatedBytes_(0),
     mouseButtons_(0),
     qualifiers_(0),
-    doubleClickInterval_(DEFAULT_DOUBLECLICK_INTERVAL),
     initialized_(false),
     usingTouchInput_(false),
     #ifdef WIN32
@@ -84,11 +160,26 @@ UI::UI(Context* context) :
     nonFocusedMouseWheel_(true),     // Default Mac OS X and Linux behaviour
     #endif
     useSystemClipBoard_(false),
-    nonModalBatchSize_(0)
+    nonModalBatchSize_(0),
+    doubleClickInterval_(DEFAULT_DOUBLECLICK_INTERVAL),
+    lastGlyphMisses_(FontFace::GetNumGlyphMisses()),
+    lastGlyphAllocations_(FontFace::GetGlyphMissAllocations()),
+    lastGlyphAllocatedBytes_(FontFace::GetGlyphMissAllocatedBytes()),
+    replayClickTime_(0),
+    dispatchingReplay_(false)
 {
     rootElement_->SetTraversalMode(TM_DEPTH_FIRST);
     rootModalElement_->SetTraversalMode(TM_DEPTH_FIRST);
     clickTimer_ = new Timer();
+    animator_ = new UIAnimator();
+    commandBuffer_ = new UICommandBuffer();
+    elementIndex_ = new UIElementIndex(rootElement_, rootModalElement_);
+    taskScheduler_ = new UITaskScheduler();
+    inputRecorder_ = new UIInputRecorder(context_);
+    binder_ = new UIBinder();
+
+    for (unsigned i = 0; i < CS_MAX_SHAPES; ++i)
+        hardwareCursors_[i] = 0;
 
     // Register UI library object factories
     RegisterUILibrary(context_);
@@ -111,11 +202,25 @@ UI::UI(Context* context) :
 
 UI::~UI()
 {
+    // The worker thread may still be reading the elements
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
+    SetHardwareCursor(false);
+    for (unsigned i = 0; i < CS_MAX_SHAPES; ++i)
+    {
+        if (hardwareCursors_[i])
+            SDL_FreeCursor(hardwareCursors_[i]);
+    }
+
     delete clickTimer_;
 }
 
 void UI::SetCursor(Cursor* cursor)
 {
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
     // Remove old cursor (if any) and set new
     if (cursor_)
     {
@@ -139,6 +244,9 @@ void UI::SetFocusElement(UIElement* element)
 {
     using namespace FocusChanged;
 
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
     VariantMap eventData;
     eventData[P_CLICKEDELEMENT] = (void*)element;
 
@@ -173,6 +281,7 @@ void UI::SetFocusElement(UIElement* element)
         VariantMap focusEventData;
         focusEventData[Defocused::P_ELEMENT] = oldFocusElement;
         oldFocusElement->SendEvent(E_DEFOCUSED, focusEventData);
+        ++frameStats_.eventsSent_;
     }
 
     // Then set focus to the new
@@ -183,10 +292,12 @@ void UI::SetFocusElement(UIElement* element)
         VariantMap focusEventData;
         focusEventData[Focused::P_ELEMENT] = element;
         element->SendEvent(E_FOCUSED, focusEventData);
+        ++frameStats_.eventsSent_;
     }
 
     eventData[P_ELEMENT] = (void*)element;
     SendEvent(E_FOCUSCHANGED, eventData);
+    ++frameStats_.eventsSent_;
 }
 
 bool UI::SetModalElement(UIElement* modalElement, bool enable)
@@ -198,6 +309,9 @@ bool UI::SetModalElement(UIElement* modalElement, bool enable)
     if (modalElement->GetType() != Window::GetTypeStatic())
         return false;
 
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
     assert(rootModalElement_);
     UIElement* currParent = modalElement->GetParent();
     if (enable)
@@ -263,6 +377,9 @@ bool UI::SetModalElement(UIElement* modalElement, bool enable)
 
 void UI::Clear()
 {
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
     rootElement_->RemoveAllChildren();
     rootModalElement_->RemoveAllChildren();
     if (cursor_)
@@ -275,6 +392,14 @@ void UI::Update(float timeStep)
 
     PROFILE(UpdateUI);
 
+    HiresTimer updateTimer;
+    UIAllocationScope allocationScope(frameStats_.updateAllocations_, frameStats_.updateAllocatedBytes_);
+
+    if (inputRecorder_->IsReplaying())
+        ReplayInput();
+
+    FlushDragMove();
+
     IntVector2 cursorPos;
     bool cursorVisible;
     GetCursorPositionAndVisible(cursorPos, cursorVisible);
@@ -311,6 +436,7 @@ void UI::Update(float timeStep)
                 eventData[P_TARGET] = (void*)element.Get();
                 eventData[P_ACCEPT] = accept;
                 SendEvent(E_DRAGDROPTEST, eventData);
+                ++frameStats_.eventsSent_;
                 accept = eventData[P_ACCEPT].GetBool();
             }
 
@@ -320,9 +446,9 @@ void UI::Update(float timeStep)
             SetCursorShape(dragElement_ == element ? CS_ACCEPTDROP : CS_REJECTDROP);
     }
 
-    // Touch hover
+    // Touch hover. Input may be missing when the UI is driven without a window, for example in benchmarks
     Input* input = GetSubsystem<Input>();
-    unsigned numTouches = input->GetNumTouches();
+    unsigned numTouches = input ? input->GetNumTouches() : 0;
 
     for (unsigned i = 0; i < numTouches; ++i)
     {
@@ -332,69 +458,606 @@ void UI::Update(float timeStep)
             element->OnHover(element->ScreenToElement(touch->position_), touch->position_, MOUSEB_LEFT, 0, 0);
     }
 
+    animator_->Update(timeStep);
+
     Update(timeStep, rootElement_);
     Update(timeStep, rootModalElement_);
+
+    // Hover handling and element updates may have changed the cursor shape
+    if (hardwareCursor_)
+        UpdateHardwareCursor();
+
+    if (taskScheduler_->GetNumTasks())
+    {
+        HiresTimer taskTimer;
+        frameStats_.tasksRun_ += taskScheduler_->Run();
+        frameStats_.taskTime_ += (unsigned)taskTimer.GetUSec(false);
+        frameStats_.taskBacklog_ = taskScheduler_->GetNumTasks();
+    }
+
+    inputRecorder_->NextFrame();
+    frameStats_.updateTime_ += (unsigned)updateTimer.GetUSec(false);
 }
 
 void UI::RenderUpdate()
 {
-    assert(rootElement_ && rootModalElement_ && graphics_);
+    assert(rootElement_ && rootModalElement_);
 
     PROFILE(GetUIBatches);
 
+    HiresTimer renderUpdateTimer;
+    UIAllocationScope allocationScope(frameStats_.renderUpdateAllocations_, frameStats_.renderUpdateAllocatedBytes_);
+
+    // Finish a build that was not consumed by rendering
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
+    ApplyBindings();
+    ApplyCommands();
+    FlushLayouts();
+
     // If the OS cursor is visible, do not render the UI's own cursor
-    bool osCursorVisible = GetSubsystem<Input>()->IsMouseVisible();
-    
-    // Get rendering batches from the non-modal UI elements
-    batches_.Clear();
-    vertexData_.Clear();
-    const IntVector2& rootSize = rootElement_->GetSize();
-    IntRect currentScissor = IntRect(0, 0, rootSize.x_, rootSize.y_);
-    GetBatches(rootElement_, currentScissor);
+    Input* input = GetSubsystem<Input>();
+    buildCursorBatches_ = !input || !input->IsMouseVisible();
 
-    // Save the batch size of the non-modal batches for later use
-    nonModalBatchSize_ = batches_.Size();
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (pipelinedBatching_ && initialized_ && queue && queue->GetNumThreads())
+    {
+        // Build the batches on a worker thread while the scene renders. Render() waits for the result. Without worker
+        // threads the item would only run when the main thread completes the queue, so build directly instead
+        WorkItem item;
+        item.workFunction_ = BuildUIBatchesWork;
+        item.start_ = 0;
+        item.end_ = 0;
+        item.aux_ = this;
+        item.priority_ = UI_BATCH_BUILD_PRIORITY;
+        item.sendEvent_ = false;
+        batchBuildPending_ = true;
+        batchBuildFinished_ = false;
+        FontFace::BeginWorkerBuild();
+        queue->AddWorkItem(item);
+    }
+    else
+    {
+        BuildBatches(batches_, vertexData_, nonModalBatchSize_);
+        frameStats_.elementsVisited_ += buildElementsVisited_;
+        frameStats_.batches_ += batches_.Size();
+        frameStats_.vertices_ += vertexData_.Size() / UI_VERTEX_SIZE;
+    }
 
-    // Get rendering batches from the modal UI elements
-    GetBatches(rootModalElement_, currentScissor);
+    frameStats_.renderUpdateTime_ += (unsigned)renderUpdateTimer.GetUSec(false);
+}
 
-    // Get batches from the cursor (and its possible children) last to draw it on top of everything
-    if (cursor_ && cursor_->IsVisible() && !osCursorVisible)
+void UI::BuildPendingBatches()
+{
+    HiresTimer buildTimer;
+    buildAllocations_ = 0;
+    buildAllocatedBytes_ = 0;
     {
-        currentScissor = IntRect(0, 0, rootSize.x_, rootSize.y_);
-        cursor_->GetBatches(batches_, vertexData_, currentScissor);
-        GetBatches(cursor_, currentScissor);
+        UIAllocationScope allocationScope(buildAllocations_, buildAllocatedBytes_);
+        BuildBatches(buildBatches_, buildVertexData_, buildNonModalBatchSize_);
     }
+    buildTime_ = (unsigned)buildTimer.GetUSec(false);
+    batchBuildFinished_ = true;
 }
 
 void UI::Render()
 {
     PROFILE(RenderUI);
 
-    SetVertexData(vertexBuffer_, vertexData_);
-    SetVertexData(debugVertexBuffer_, debugVertexData_);
+    HiresTimer renderTimer;
 
-    // Render non-modal batches
-    Render(vertexBuffer_, batches_, 0, nonModalBatchSize_);
-    // Render debug draw
-    Render(debugVertexBuffer_, debugDrawBatches_, 0, debugDrawBatches_.Size());
-    // Render modal batches
-    Render(vertexBuffer_, batches_, nonModalBatchSize_, batches_.Size());
+    // Without graphics only finish the frame statistics, so that batch generation can be measured headless
+    if (!initialized_)
+    {
+        EndFrameStats();
+        return;
+    }
+
+    {
+        UIAllocationScope allocationScope(frameStats_.renderAllocations_, frameStats_.renderAllocatedBytes_);
+
+        if (batchBuildPending_)
+            CompleteBatchBuild();
+
+        SetVertexData(vertexBuffer_, vertexData_);
+        SetVertexData(debugVertexBuffer_, debugVertexData_);
+
+        // Render non-modal batches
+        Render(vertexBuffer_, batches_, 0, nonModalBatchSize_);
+        // Render debug draw
+        Render(debugVertexBuffer_, debugDrawBatches_, 0, debugDrawBatches_.Size());
+        // Render modal batches
+        Render(vertexBuffer_, batches_, nonModalBatchSize_, batches_.Size());
+
+        // Clear the debug draw batches and data
+        debugDrawBatches_.Clear();
+        debugVertexData_.Clear();
+    }
 
-    // Clear the debug draw batches and data
-    debugDrawBatches_.Clear();
-    debugVertexData_.Clear();
+    frameStats_.renderTime_ += (unsigned)renderTimer.GetUSec(false);
+    EndFrameStats();
+}
+
+bool UI::RenderToImage(Image* image, const Color& clearColor)
+{
+    PROFILE(RenderUIToImage);
+
+    if (!image)
+        return false;
+
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
+    if (!softwareRenderer_)
+        softwareRenderer_ = new UISoftwareRenderer();
+
+    // Without a graphics device the frame events are not subscribed, so build the batches here
+    if (!initialized_)
+        RenderUpdate();
+
+    SetFontTextureImages();
+
+    const IntVector2& rootSize = rootElement_->GetSize();
+    return softwareRenderer_->Render(image, rootSize.x_, rootSize.y_, batches_, vertexData_, clearColor);
+}
+
+void UI::SetSoftwareTextureImage(Texture* texture, Image* image)
+{
+    if (!softwareRenderer_)
+        softwareRenderer_ = new UISoftwareRenderer();
+
+    softwareRenderer_->SetTextureImage(texture, image);
+}
+
+void UI::SetHeadlessSize(const IntVector2& size)
+{
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
+    if (initialized_)
+    {
+        LOGWARNING("Can not set headless UI size when a graphics device is in use");
+        return;
+    }
+
+    // Fonts load without a graphics device only when rendering in software
+    if (!softwareRenderer_)
+        softwareRenderer_ = new UISoftwareRenderer();
+
+    rootElement_->SetSize(size);
+    rootModalElement_->SetSize(rootElement_->GetSize());
 }
 
 void UI::DebugDraw(UIElement* element)
 {
     if (element)
     {
+        if (batchBuildPending_)
+            CompleteBatchBuild();
+
         const IntVector2& rootSize = rootElement_->GetSize();
         element->GetDebugDrawBatches(debugDrawBatches_, debugVertexData_, IntRect(0, 0, rootSize.x_, rootSize.y_));
     }
 }
 
+void UI::AddTask(UITask* task, int priority)
+{
+    taskScheduler_->AddTask(task, priority);
+}
+
+void UI::RemoveTask(UITask* task)
+{
+    taskScheduler_->RemoveTask(task);
+}
+
+void UI::RemoveAllTasks()
+{
+    taskScheduler_->RemoveAllTasks();
+}
+
+void UI::SetTaskBudget(float budget)
+{
+    taskScheduler_->SetBudget(budget);
+}
+
+bool UI::SetAllocationCheck(bool enable)
+{
+    if (enable && !UIAllocationScope::IsEnabled())
+    {
+        LOGERROR("Allocations are not being counted, can not enable the UI allocation check. Use DEFINE_UI_ALLOCATION_TRACKING() "
+            "in the application and link the engine statically");
+        allocationCheck_ = false;
+        return false;
+    }
+
+    allocationCheck_ = enable;
+    return true;
+}
+
+void UI::SetPipelinedBatching(bool enable)
+{
+    if (!enable && batchBuildPending_)
+        CompleteBatchBuild();
+    pipelinedBatching_ = enable;
+}
+
+void UI::DeferLayout(UIElement* element)
+{
+    if (!element)
+        return;
+
+    for (unsigned i = 0; i < deferredLayouts_.Size(); ++i)
+    {
+        if (deferredLayouts_[i].Get() == element)
+            return;
+    }
+
+    element->DisableLayoutUpdate();
+    deferredLayouts_.Push(WeakPtr<UIElement>(element));
+}
+
+void UI::FlushLayouts()
+{
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
+    if (deferredLayouts_.Empty())
+        return;
+
+    PROFILE(FlushUILayouts);
+
+    // Layout updates may defer further elements, so take the list first
+    Vector<WeakPtr<UIElement> > elements;
+    elements.Swap(deferredLayouts_);
+    for (unsigned i = 0; i < elements.Size(); ++i)
+    {
+        UIElement* element = elements[i];
+        if (element)
+        {
+            element->EnableLayoutUpdate();
+            element->UpdateLayout();
+        }
+    }
+}
+
+void UI::SetCoalesceDragMoves(bool enable)
+{
+    if (!enable)
+        FlushDragMove();
+    coalesceDragMoves_ = enable;
+}
+
+void UI::Bind(UIElement* element, const String& attribute, UIObservable* observable)
+{
+    binder_->Bind(element, attribute, observable);
+}
+
+void UI::Unbind(UIElement* element, const String& attribute)
+{
+    binder_->Unbind(element, attribute);
+}
+
+void UI::UnbindAll(UIElement* element)
+{
+    binder_->UnbindAll(element);
+}
+
+void UI::ApplyBindings()
+{
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
+    binder_->Apply();
+}
+
+void UI::SetClickDelegate(UIElement* element, UIEventDelegate* delegate)
+{
+    clickDelegates_.Set(element, delegate);
+}
+
+void UI::SetClickEndDelegate(UIElement* element, UIEventDelegate* delegate)
+{
+    clickEndDelegates_.Set(element, delegate);
+}
+
+void UI::SetTextEditBuffer(UIElement* element, TextEditBuffer* buffer)
+{
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
+    if (!element)
+        return;
+
+    // Store in the element's variables so that the association ends with the element
+    if (buffer)
+        element->SetVar(VAR_TEXTEDITBUFFER, (void*)buffer);
+    else
+        const_cast<VariantMap&>(element->GetVars()).Erase(VAR_TEXTEDITBUFFER);
+}
+
+void UI::AddTag(UIElement* element, const String& tag)
+{
+    elementIndex_->AddTag(element, tag);
+}
+
+void UI::RemoveTag(UIElement* element, const String& tag)
+{
+    elementIndex_->RemoveTag(element, tag);
+}
+
+void UI::RemoveAllTags(UIElement* element)
+{
+    elementIndex_->RemoveAllTags(element);
+}
+
+bool UI::DefineHardwareCursorShape(CursorShape shape, Image* image, const IntRect& imageRect, const IntVector2& hotSpot)
+{
+    if (shape >= CS_MAX_SHAPES)
+        return false;
+    if (!image)
+    {
+        LOGERROR("Null image for hardware cursor");
+        return false;
+    }
+
+    IntRect rect = imageRect;
+    if (rect == IntRect::ZERO)
+        rect = IntRect(0, 0, image->GetWidth(), image->GetHeight());
+    int width = rect.Width();
+    int height = rect.Height();
+    unsigned components = image->GetComponents();
+    if (rect.left_ < 0 || rect.top_ < 0 || rect.right_ > image->GetWidth() || rect.bottom_ > image->GetHeight() || width <= 0 ||
+        height <= 0 || image->IsCompressed())
+    {
+        LOGERROR("Unsupported image or rectangle for hardware cursor");
+        return false;
+    }
+
+    // Convert to 32-bit RGBA, which SDL cursor creation accepts on all platforms
+    SDL_Surface* surface = SDL_CreateRGBSurface(0, width, height, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+    if (!surface)
+        return false;
+
+    SDL_LockSurface(surface);
+    const unsigned char* imageData = image->GetData();
+    for (int y = 0; y < height; ++y)
+    {
+        const unsigned char* src = imageData + ((rect.top_ + y) * image->GetWidth() + rect.left_) * components;
+        unsigned char* dest = (unsigned char*)surface->pixels + y * surface->pitch;
+        for (int x = 0; x < width; ++x)
+        {
+            switch (components)
+            {
+            case 1:
+                dest[0] = dest[1] = dest[2] = 255;
+                dest[3] = src[0];
+                break;
+
+            case 2:
+                dest[0] = dest[1] = dest[2] = src[0];
+                dest[3] = src[1];
+                break;
+
+            case 3:
+                dest[0] = src[0];
+                dest[1] = src[1];
+                dest[2] = src[2];
+                dest[3] = 255;
+                break;
+
+            default:
+                dest[0] = src[0];
+                dest[1] = src[1];
+                dest[2] = src[2];
+                dest[3] = src[3];
+                break;
+            }
+            src += components;
+            dest += 4;
+        }
+    }
+    SDL_UnlockSurface(surface);
+
+    SDL_Cursor* cursor = SDL_CreateColorCursor(surface, hotSpot.x_, hotSpot.y_);
+    SDL_FreeSurface(surface);
+    if (!cursor)
+    {
+        LOGERROR("Could not create hardware cursor: " + String(SDL_GetError()));
+        return false;
+    }
+
+    SDL_Cursor* oldCursor = hardwareCursors_[shape];
+    hardwareCursors_[shape] = cursor;
+
+    // If the shape is current, show the new cursor before freeing the old one, which may be shown
+    if (hardwareCursor_ && hardwareCursorShape_ == shape)
+    {
+        hardwareCursorShape_ = CS_MAX_SHAPES;
+        UpdateHardwareCursor();
+    }
+    if (oldCursor)
+        SDL_FreeCursor(oldCursor);
+
+    return true;
+}
+
+bool UI::SetHardwareCursor(bool enable)
+{
+    Input* input = GetSubsystem<Input>();
+
+    if (enable && !hardwareCursor_)
+    {
+        if (!initialized_ || !input || !hardwareCursors_[CS_NORMAL])
+        {
+            LOGWARNING("Hardware cursor not available, using software cursor");
+            return false;
+        }
+
+        // When the OS cursor is visible, the cursor element is not rendered, but still follows the mouse for hit testing
+        mouseVisibleBeforeHardwareCursor_ = input->IsMouseVisible();
+        input->SetMouseVisible(true);
+        hardwareCursor_ = true;
+        hardwareCursorShape_ = CS_MAX_SHAPES;
+        UpdateHardwareCursor();
+    }
+    else if (!enable && hardwareCursor_)
+    {
+        hardwareCursor_ = false;
+        SDL_SetCursor(SDL_GetDefaultCursor());
+        if (input)
+            input->SetMouseVisible(mouseVisibleBeforeHardwareCursor_);
+    }
+
+    return hardwareCursor_;
+}
+
+void UI::SetCompositionText(const String& text, unsigned cursor)
+{
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
+    DecodeUTF8(text, compositionChars_);
+    if (cursor > compositionChars_.Size())
+        cursor = compositionChars_.Size();
+
+    if (text == compositionText_ && cursor == compositionCursor_)
+        return;
+
+    compositionText_ = text;
+    compositionCursor_ = cursor;
+    compositionRun_.Clear();
+
+    using namespace UIComposition;
+
+    VariantMap eventData;
+    eventData[P_ELEMENT] = (void*)focusElement_.Get();
+    eventData[P_TEXT] = compositionText_;
+    eventData[P_CURSOR] = compositionCursor_;
+    SendEvent(E_UICOMPOSITION, eventData);
+    ++frameStats_.eventsSent_;
+}
+
+void UI::SetCompositionPosition(const IntVector2& position)
+{
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
+    compositionPosition_ = position;
+    compositionPositionSet_ = true;
+}
+
+void UI::SetCompositionFont(Font* font, int size)
+{
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
+    compositionFont_ = font;
+    compositionFontSize_ = Max(size, 1);
+    compositionRun_.Clear();
+}
+
+void UI::SetCompositionColor(const Color& color)
+{
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
+    compositionColor_ = color;
+}
+
+void UI::CommitText(const String& text)
+{
+    SetCompositionText(String::EMPTY);
+
+    // The whole commit goes to the element that had focus when it began, even if handling a character moves the focus
+    SharedPtr<UIElement> element(focusElement_);
+    if (!element || text.Empty())
+        return;
+
+    // An editor with a text editing buffer takes the whole commit as one edit
+    TextEditBuffer* buffer = GetTextEditBuffer(element);
+    if (buffer)
+    {
+        buffer->InsertAtCursor(text);
+
+        // The event carries the whole text, so skip encoding it when nobody listens
+        HashSet<Object*>* receivers = context_->GetEventReceivers(E_TEXTCHANGED);
+        HashSet<Object*>* senderReceivers = context_->GetEventReceivers(element, E_TEXTCHANGED);
+        if ((!receivers || receivers->Empty()) && (!senderReceivers || senderReceivers->Empty()))
+            return;
+
+        using namespace TextChanged;
+
+        VariantMap eventData;
+        eventData[P_ELEMENT] = (void*)element.Get();
+        eventData[P_TEXT] = buffer->GetText();
+        element->SendEvent(E_TEXTCHANGED, eventData);
+        ++frameStats_.eventsSent_;
+        return;
+    }
+
+    PODVector<unsigned> chars;
+    DecodeUTF8(text, chars);
+    for (unsigned i = 0; i < chars.Size() && element->GetParent(); ++i)
+        element->OnChar(chars[i], mouseButtons_, qualifiers_);
+}
+
+bool UI::BeginInputRecording(const String& fileName)
+{
+    EndInputRecording();
+
+    // Record the initial state that the first events depend on
+    UIInputRecordingState state;
+    if (!GetMousePositionAndVisible(state.mousePosition_, state.mouseVisible_))
+    {
+        state.mousePosition_ = IntVector2::ZERO;
+        state.mouseVisible_ = false;
+    }
+    state.rootSize_ = rootElement_->GetSize();
+    state.hasCursor_ = cursor_ != 0;
+    if (cursor_)
+    {
+        state.cursorPosition_ = cursor_->GetPosition();
+        state.cursorVisible_ = cursor_->IsVisible();
+    }
+
+    return inputRecorder_->BeginRecording(fileName, state);
+}
+
+void UI::EndInputRecording()
+{
+    inputRecorder_->EndRecording();
+}
+
+bool UI::BeginInputReplay(const String& fileName)
+{
+    EndInputReplay();
+
+    UIInputRecordingState state;
+    if (!inputRecorder_->BeginReplay(fileName, state))
+        return false;
+
+    // Restore the initial state so that the events hit the same elements as when recorded
+    rootElement_->SetSize(state.rootSize_);
+    rootModalElement_->SetSize(state.rootSize_);
+    if (state.hasCursor_ != (cursor_ != 0))
+        LOGWARNING("UI cursor presence differs from the input recording, replay may diverge");
+    if (cursor_ && state.hasCursor_)
+    {
+        cursor_->SetPosition(state.cursorPosition_);
+        cursor_->SetVisible(state.cursorVisible_);
+    }
+
+    replayFrameStats_.Clear();
+    replayClickTime_ = 0;
+    return true;
+}
+
+void UI::EndInputReplay()
+{
+    inputRecorder_->EndReplay();
+}
+
 SharedPtr<UIElement> UI::LoadLayout(Deserializer& source, XMLFile* styleFile)
 {
     SharedPtr<XMLFile> xml(new XMLFile(context_));
@@ -418,6 +1081,10 @@ SharedPtr<UIElement> UI::LoadLayout(XMLFile* file, XMLFile* styleFile)
 
     LOGDEBUG("Loading UI layout " + file->GetName());
 
+    // Loading may create font faces, which the worker thread must not see change
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
     XMLElement rootElem = file->GetRoot("element");
     if (!rootElem)
     {
@@ -476,13 +1143,73 @@ void UI::SetUseSystemClipBoard(bool enable)
     useSystemClipBoard_ = enable;
 }
 
+void UI::SetTexts(const PODVector<UIElement*>& elements, const Vector<String>& texts)
+{
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
+    commandBuffer_->SetTexts(elements, texts);
+}
+
+void UI::SetPositions(const PODVector<UIElement*>& elements, const PODVector<IntVector2>& positions)
+{
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
+    commandBuffer_->SetPositions(elements, positions);
+}
+
+void UI::QueueSetText(UIElement* element, const String& text)
+{
+    commandBuffer_->QueueSetText(element, text);
+}
+
+void UI::QueueSetPosition(UIElement* element, const IntVector2& position)
+{
+    commandBuffer_->QueueSetPosition(element, position);
+}
+
+void UI::QueueSetColor(UIElement* element, const Color& color)
+{
+    commandBuffer_->QueueSetColor(element, color);
+}
+
+void UI::QueueSetVisible(UIElement* element, bool visible)
+{
+    commandBuffer_->QueueSetVisible(element, visible);
+}
+
+void UI::QueueSetOpacity(UIElement* element, float opacity)
+{
+    commandBuffer_->QueueSetOpacity(element, opacity);
+}
+
+void UI::ApplyCommands()
+{
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
+    commandBuffer_->Apply();
+}
+
 IntVector2 UI::GetCursorPosition() const
 {
-    return cursor_ ? cursor_->GetPosition() : GetSubsystem<Input>()->GetMousePosition();
+    if (cursor_)
+        return cursor_->GetPosition();
+
+    IntVector2 pos;
+    bool visible;
+    return GetMousePositionAndVisible(pos, visible) ? pos : IntVector2::ZERO;
 }
 
 UIElement* UI::GetElementAt(const IntVector2& position, bool enabledOnly)
 {
+    // Hit testing updates the elements' cached screen positions
+    if (batchBuildPending_)
+        CompleteBatchBuild();
+
+    ++frameStats_.hitTests_;
+
     UIElement* result = 0;
     GetElementAt(result, HasModalElement() ? rootModalElement_ : rootElement_, position, enabledOnly);
     return result;
@@ -493,6 +1220,36 @@ UIElement* UI::GetElementAt(int x, int y, bool enabledOnly)
     return GetElementAt(IntVector2(x, y), enabledOnly);
 }
 
+UIElement* UI::FindElement(const String& name)
+{
+    return elementIndex_->FindElement(name);
+}
+
+UIEventDelegate* UI::GetClickDelegate(UIElement* element) const
+{
+    return clickDelegates_.Get(element);
+}
+
+UIEventDelegate* UI::GetClickEndDelegate(UIElement* element) const
+{
+    return clickEndDelegates_.Get(element);
+}
+
+TextEditBuffer* UI::GetTextEditBuffer(UIElement* element) const
+{
+    return element ? static_cast<TextEditBuffer*>(element->GetVar(VAR_TEXTEDITBUFFER).GetVoidPtr()) : 0;
+}
+
+bool UI::HasTag(UIElement* element, const String& tag) const
+{
+    return elementIndex_->HasTag(element, tag);
+}
+
+PODVector<UIElement*> UI::GetElementsWithTag(const String& tag)
+{
+    return elementIndex_->GetElementsWithTag(tag);
+}
+
 UIElement* UI::GetFrontElement() const
 {
     const Vector<SharedPtr<UIElement> >& rootChildren = rootElement_->GetChildren();
@@ -570,6 +1327,7 @@ void UI::Initialize()
 void UI::Update(float timeStep, UIElement* element)
 {
     element->Update(timeStep);
+    ++frameStats_.elementsVisited_;
 
     const Vector<SharedPtr<UIElement> >& children = element->GetChildren();
     for (Vector<SharedPtr<UIElement> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
@@ -588,6 +1346,7 @@ void UI::SetVertexData(VertexBuffer* dest, const PODVector<float>& vertexData)
         dest->SetSize(numVertices, MASK_POSITION | MASK_COLOR | MASK_TEXCOORD1, true);
 
     dest->SetData(&vertexData[0]);
+    frameStats_.uploadedBytes_ += vertexData.Size() * sizeof(float);
 }
 
 void UI::Render(VertexBuffer* buffer, const PODVector<UIBatch>& batches, unsigned batchStart, unsigned batchEnd)
@@ -661,11 +1420,130 @@ void UI::Render(VertexBuffer* buffer, const PODVector<UIBatch>& batches, unsigne
         graphics_->SetTexture(0, batch.texture_);
         graphics_->Draw(TRIANGLE_LIST, batch.vertexStart_ / UI_VERTEX_SIZE, (batch.vertexEnd_ - batch.vertexStart_) /
             UI_VERTEX_SIZE);
+        ++frameStats_.drawCalls_;
     }
 }
 
-void UI::GetBatches(UIElement* element, IntRect currentScissor)
+void UI::BuildBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, unsigned& nonModalBatchSize)
 {
+    // Get rendering batches from the non-modal UI elements. The build may run on the worker thread, so count visits separately
+    // and merge them into the frame statistics on the main thread
+    buildElementsVisited_ = 0;
+    batches.Clear();
+    vertexData.Clear();
+    const IntVector2& rootSize = rootElement_->GetSize();
+    IntRect currentScissor = IntRect(0, 0, rootSize.x_, rootSize.y_);
+    GetBatches(batches, vertexData, rootElement_, currentScissor);
+
+    // Save the batch size of the non-modal batches for later use
+    nonModalBatchSize = batches.Size();
+
+    // Get rendering batches from the modal UI elements
+    GetBatches(batches, vertexData, rootModalElement_, currentScissor);
+
+    // Draw the input method composition on top of the elements, but below the cursor
+    if (!compositionChars_.Empty())
+        GetCompositionBatches(batches, vertexData, currentScissor);
+
+    // Get batches from the cursor (and its possible children) last to draw it on top of everything
+    if (cursor_ && cursor_->IsVisible() && buildCursorBatches_)
+    {
+        currentScissor = IntRect(0, 0, rootSize.x_, rootSize.y_);
+        cursor_->GetBatches(batches, vertexData, currentScissor);
+        GetBatches(batches, vertexData, cursor_, currentScissor);
+    }
+}
+
+void UI::CompleteBatchBuild()
+{
+    PROFILE(CompleteUIBatches);
+
+    // Wait only for the UI build. Completing the work queue would also wait for all other queued work
+    while (!batchBuildFinished_)
+        Time::Sleep(0);
+    batchBuildPending_ = false;
+
+    // Swap the buffers, so that the next build reuses the previous frame's memory
+    batches_.Swap(buildBatches_);
+    vertexData_.Swap(buildVertexData_);
+    nonModalBatchSize_ = buildNonModalBatchSize_;
+    frameStats_.elementsVisited_ += buildElementsVisited_;
+
+    // The worker can not render glyphs or create font faces. If it needed any, build again on the main thread, which renders them
+    if (FontFace::EndWorkerBuild())
+    {
+        HiresTimer rebuildTimer;
+        BuildBatches(batches_, vertexData_, nonModalBatchSize_);
+        frameStats_.elementsVisited_ += buildElementsVisited_;
+        buildTime_ += (unsigned)rebuildTimer.GetUSec(false);
+    }
+
+    frameStats_.batches_ += batches_.Size();
+    frameStats_.vertices_ += vertexData_.Size() / UI_VERTEX_SIZE;
+    frameStats_.renderUpdateTime_ += buildTime_;
+    frameStats_.renderUpdateAllocations_ += buildAllocations_;
+    frameStats_.renderUpdateAllocatedBytes_ += buildAllocatedBytes_;
+}
+
+void UI::GetCompositionBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor)
+{
+    if (!compositionFont_)
+        return;
+    const FontFace* face = compositionFont_->GetFace(compositionFontSize_);
+    if (!face)
+        return;
+
+    IntVector2 position = compositionPosition_;
+    if (!compositionPositionSet_)
+    {
+        if (!focusElement_)
+            return;
+        position = focusElement_->GetScreenPosition();
+    }
+
+    // Lay out and build the glyph quads only when the composition changes. Moving the overlay just translates them
+    if (!compositionRun_.IsValid(rootElement_, face, compositionColor_))
+    {
+        compositionPositions_.Resize(compositionChars_.Size());
+        int x = 0;
+        compositionCursorX_ = 0;
+        for (unsigned i = 0; i < compositionChars_.Size(); ++i)
+        {
+            if (i == compositionCursor_)
+                compositionCursorX_ = x;
+            compositionPositions_[i] = IntVector2(x, 0);
+
+            unsigned c = compositionChars_[i];
+            const FontGlyph* glyph = face->GetGlyphMetrics(c);
+            if (!glyph)
+                continue;
+            x += glyph->advanceX_;
+            if (i + 1 < compositionChars_.Size())
+                x += face->GetKerning(c, compositionChars_[i + 1]);
+        }
+        if (compositionCursor_ >= compositionChars_.Size())
+            compositionCursorX_ = x;
+        compositionWidth_ = x;
+
+        compositionRun_.Build(rootElement_, face, &compositionChars_[0], &compositionPositions_[0], compositionChars_.Size(),
+            compositionColor_);
+    }
+
+    // The batches belong to the root element, which is at the screen origin
+    compositionRun_.GetBatches(batches, vertexData, rootElement_, currentScissor, position);
+
+    // Underline the composition and mark the cursor within it
+    UIBatch lineBatch(rootElement_, BLEND_ALPHA, currentScissor, 0, &vertexData);
+    lineBatch.SetColor(compositionColor_);
+    lineBatch.AddQuad(position.x_, position.y_ + face->rowHeight_ - 1, compositionWidth_, 1, 0, 0);
+    lineBatch.AddQuad(position.x_ + compositionCursorX_, position.y_, 1, face->rowHeight_, 0, 0);
+    UIBatch::AddOrMerge(lineBatch, batches);
+}
+
+void UI::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, UIElement* element, IntRect currentScissor)
+{
+    ++buildElementsVisited_;
+
     // Set clipping scissor for child elements. No need to draw if zero size
     element->AdjustScissor(currentScissor);
     if (currentScissor.left_ == currentScissor.right_ || currentScissor.top_ == currentScissor.bottom_)
@@ -688,14 +1566,14 @@ void UI::GetBatches(UIElement* element, IntRect currentScissor)
             while (j != children.End() && (*j)->GetPriority() == currentPriority)
             {
                 if ((*j)->IsWithinScissor(currentScissor) && (*j) != cursor_)
-                    (*j)->GetBatches(batches_, vertexData_, currentScissor);
+                    (*j)->GetBatches(batches, vertexData, currentScissor);
                 ++j;
             }
             // Now recurse into the children
             while (i != j)
             {
                 if ((*i)->IsVisible() && (*i) != cursor_)
-                    GetBatches(*i, currentScissor);
+                    GetBatches(batches, vertexData, *i, currentScissor);
                 ++i;
             }
         }
@@ -708,9 +1586,9 @@ void UI::GetBatches(UIElement* element, IntRect currentScissor)
             if ((*i) != cursor_)
             {
                 if ((*i)->IsWithinScissor(currentScissor))
-                    (*i)->GetBatches(batches_, vertexData_, currentScissor);
+                    (*i)->GetBatches(batches, vertexData, currentScissor);
                 if ((*i)->IsVisible())
-                    GetBatches(*i, currentScissor);
+                    GetBatches(batches, vertexData, *i, currentScissor);
             }
             ++i;
         }
@@ -804,11 +1682,10 @@ void UI::GetCursorPositionAndVisible(IntVector2& pos, bool& visible)
         pos = cursor_->GetPosition();
         visible = cursor_->IsVisible();
     }
-    else
+    else if (!GetMousePositionAndVisible(pos, visible))
     {
-        Input* input = GetSubsystem<Input>();
-        pos = input->GetMousePosition();
-        visible = input->IsMouseVisible();
+        pos = IntVector2::ZERO;
+        visible = false;
     }
 }
 
@@ -818,8 +1695,40 @@ void UI::SetCursorShape(CursorShape shape)
         cursor_->SetShape(shape);
 }
 
+void UI::UpdateHardwareCursor()
+{
+    CursorShape shape = cursor_ ? cursor_->GetShape() : CS_NORMAL;
+    if (shape == hardwareCursorShape_)
+        return;
+
+    Input* input = GetSubsystem<Input>();
+    if (hardwareCursors_[shape])
+    {
+        // When returning from the software cursor, show the OS cursor where the cursor element is
+        if (!input->IsMouseVisible())
+        {
+            input->SetMouseVisible(true);
+            if (cursor_)
+            {
+                const IntVector2& pos = cursor_->GetPosition();
+                SDL_WarpMouseInWindow(0, pos.x_, pos.y_);
+            }
+        }
+        SDL_SetCursor(hardwareCursors_[shape]);
+    }
+    else
+    {
+        // Shapes without a hardware cursor hide the OS cursor, so that the cursor element renders them
+        input->SetMouseVisible(false);
+    }
+
+    hardwareCursorShape_ = shape;
+}
+
 void UI::ProcessClickBegin(const IntVector2& cursorPos, int button, int buttons, int qualifiers, Cursor* cursor, bool cursorVisible)
 {
+    FlushDragMove();
+
     if (cursorVisible)
     {
         WeakPtr<UIElement> element(GetElementAt(cursorPos));
@@ -835,14 +1744,18 @@ void UI::ProcessClickBegin(const IntVector2& cursorPos, int button, int buttons,
 
             // Handle click
             element->OnClickBegin(element->ScreenToElement(cursorPos), cursorPos, button, buttons, qualifiers, cursor);
+            clickDelegates_.Invoke(element, cursorPos);
             SendClickEvent(E_UIMOUSECLICK, element, cursorPos, button, buttons, qualifiers);
 
             // Remember element clicked on for the click end
             clickElement_ = element;
             
             // Fire double click event if element matches and is in time
-            if (doubleClickElement_ && element == doubleClickElement_ && clickTimer_->GetMSec(true) <
-                (unsigned)(doubleClickInterval_ * 1000) && lastMouseButtons_ == buttons)
+            // When replaying, measure the interval with the recorded event times instead of the wall clock
+            unsigned clickInterval = inputRecorder_->IsReplaying() ? inputRecorder_->GetReplayTime() - replayClickTime_ :
+                clickTimer_->GetMSec(true);
+            if (doubleClickElement_ && element == doubleClickElement_ && clickInterval < (unsigned)(doubleClickInterval_ * 1000) &&
+                lastMouseButtons_ == buttons)
             {
                 element->OnDoubleClick(element->ScreenToElement(cursorPos), cursorPos, button, buttons, qualifiers, cursor);
                 doubleClickElement_.Reset();
@@ -852,6 +1765,7 @@ void UI::ProcessClickBegin(const IntVector2& cursorPos, int button, int buttons,
             {
                 doubleClickElement_ = element;
                 clickTimer_->Reset();
+                replayClickTime_ = inputRecorder_->GetReplayTime();
             }
             
             // Handle start of drag. Click handling may have caused destruction of the element, so check the pointer again
@@ -875,13 +1789,19 @@ void UI::ProcessClickBegin(const IntVector2& cursorPos, int button, int buttons,
 
 void UI::ProcessClickEnd(const IntVector2& cursorPos, int button, int buttons, int qualifiers, Cursor* cursor, bool cursorVisible)
 {
+    // Deliver the last drag move before the drag ends
+    FlushDragMove();
+
     if (cursorVisible)
     {
         WeakPtr<UIElement> element(GetElementAt(cursorPos));
 
         // Handle end of click
         if (element)
+        {
             element->OnClickEnd(element->ScreenToElement(cursorPos), cursorPos, button, buttons, qualifiers, cursor, clickElement_);
+            clickEndDelegates_.Invoke(element, cursorPos);
+        }
         
         SendClickEvent(E_UIMOUSECLICKEND, element, cursorPos, button, buttons, qualifiers);
         
@@ -913,6 +1833,7 @@ void UI::ProcessClickEnd(const IntVector2& cursorPos, int button, int buttons, i
                             eventData[P_TARGET] = (void*)element.Get();
                             eventData[P_ACCEPT] = accept;
                             SendEvent(E_DRAGDROPFINISH, eventData);
+                            ++frameStats_.eventsSent_;
                         }
                     }
                 }
@@ -931,11 +1852,21 @@ void UI::ProcessMove(const IntVector2& cursorPos, int buttons, int qualifiers, C
     {
         if (dragElement_->IsEnabled() && dragElement_->IsVisible())
         {
-            dragElement_->OnDragMove(dragElement_->ScreenToElement(cursorPos), cursorPos, buttons, qualifiers, cursor);
-            SendDragEvent(E_DRAGMOVE, dragElement_, cursorPos);
+            // Drag moves use absolute positions, so only the last one of the frame needs to be handled
+            if (coalesceDragMoves_)
+            {
+                dragMovePending_ = true;
+                dragMovePosition_ = cursorPos;
+                dragMoveButtons_ = buttons;
+                dragMoveQualifiers_ = qualifiers;
+                dragMoveCursor_ = cursor;
+            }
+            else
+                ProcessDragMove(cursorPos, buttons, qualifiers, cursor);
         }
         else
         {
+            dragMovePending_ = false;
             dragElement_->OnDragEnd(dragElement_->ScreenToElement(cursorPos), cursorPos, cursor);
             SendDragEvent(E_DRAGEND, dragElement_, cursorPos);
             dragElement_.Reset();
@@ -943,6 +1874,22 @@ void UI::ProcessMove(const IntVector2& cursorPos, int buttons, int qualifiers, C
     }
 }
 
+void UI::ProcessDragMove(const IntVector2& cursorPos, int buttons, int qualifiers, Cursor* cursor)
+{
+    dragElement_->OnDragMove(dragElement_->ScreenToElement(cursorPos), cursorPos, buttons, qualifiers, cursor);
+    SendDragEvent(E_DRAGMOVE, dragElement_, cursorPos);
+}
+
+void UI::FlushDragMove()
+{
+    if (!dragMovePending_)
+        return;
+
+    dragMovePending_ = false;
+    if (dragElement_ && dragElement_->IsEnabled() && dragElement_->IsVisible())
+        ProcessDragMove(dragMovePosition_, dragMoveButtons_, dragMoveQualifiers_, dragMoveCursor_);
+}
+
 void UI::SendDragEvent(StringHash eventType, UIElement* element, const IntVector2& screenPos)
 {
     if (!element)
@@ -960,10 +1907,17 @@ void UI::SendDragEvent(StringHash eventType, UIElement* element, const IntVector
     eventData[P_ELEMENTY] = relativePos.y_;
 
     element->SendEvent(eventType, eventData);
+    ++frameStats_.eventsSent_;
 }
 
 void UI::SendClickEvent(StringHash eventType, UIElement* element, const IntVector2& pos, int button, int buttons, int qualifiers)
 {
+    // Skip building the event parameters when nobody listens, for example when only delegates are used
+    HashSet<Object*>* receivers = context_->GetEventReceivers(eventType);
+    HashSet<Object*>* senderReceivers = context_->GetEventReceivers(this, eventType);
+    if ((!receivers || receivers->Empty()) && (!senderReceivers || senderReceivers->Empty()))
+        return;
+
     VariantMap eventData;
     eventData[UIMouseClick::P_ELEMENT] = (void*)element;
     eventData[UIMouseClick::P_X] = pos.x_;
@@ -977,6 +1931,150 @@ void UI::SendClickEvent(StringHash eventType, UIElement* element, const IntVecto
         eventData[UIMouseClickEnd::P_BEGINELEMENT] = clickElement_;
     
     SendEvent(eventType, eventData);
+    ++frameStats_.eventsSent_;
+}
+
+void UI::EndFrameStats()
+{
+    // The font faces count glyph misses themselves, so take the difference since the previous frame
+    unsigned glyphMisses = FontFace::GetNumGlyphMisses();
+    unsigned glyphAllocations = FontFace::GetGlyphMissAllocations();
+    unsigned glyphAllocatedBytes = FontFace::GetGlyphMissAllocatedBytes();
+    frameStats_.glyphMisses_ = glyphMisses - lastGlyphMisses_;
+    frameStats_.glyphAllocations_ = glyphAllocations - lastGlyphAllocations_;
+    frameStats_.glyphAllocatedBytes_ = glyphAllocatedBytes - lastGlyphAllocatedBytes_;
+    lastGlyphMisses_ = glyphMisses;
+    lastGlyphAllocations_ = glyphAllocations;
+    lastGlyphAllocatedBytes_ = glyphAllocatedBytes;
+
+    if (allocationCheck_)
+    {
+        unsigned allocations = frameStats_.updateAllocations_ + frameStats_.renderUpdateAllocations_ + frameStats_.renderAllocations_ +
+            frameStats_.inputAllocations_;
+        if (allocations)
+        {
+            ++allocationCheckFailures_;
+            LOGERROR("UI frame allocated " + String(allocations) + " times: update " + String(frameStats_.updateAllocations_) + " (" +
+                String(frameStats_.updateAllocatedBytes_) + " bytes), render update " + String(frameStats_.renderUpdateAllocations_) +
+                " (" + String(frameStats_.renderUpdateAllocatedBytes_) + " bytes), render " + String(frameStats_.renderAllocations_) +
+                " (" + String(frameStats_.renderAllocatedBytes_) + " bytes), input " + String(frameStats_.inputAllocations_) + " (" +
+                String(frameStats_.inputAllocatedBytes_) + " bytes), glyphs " + String(frameStats_.glyphAllocations_) + " (" +
+                String(frameStats_.glyphAllocatedBytes_) + " bytes)");
+            assert(!"UI frame allocated with the allocation check enabled");
+        }
+    }
+
+    if (inputRecorder_->IsReplaying())
+        replayFrameStats_.Push(frameStats_);
+
+    lastFrameStats_ = frameStats_;
+    frameStats_.Reset();
+}
+
+bool UI::FilterInput(StringHash eventType, VariantMap& eventData)
+{
+    // Ignore live input during replay so that the recorded session is reproduced exactly
+    if (inputRecorder_->IsReplaying() && !dispatchingReplay_)
+        return false;
+
+    if (inputRecorder_->IsRecording())
+    {
+        IntVector2 mousePos;
+        bool mouseVisible;
+        if (!GetMousePositionAndVisible(mousePos, mouseVisible))
+        {
+            mousePos = IntVector2::ZERO;
+            mouseVisible = false;
+        }
+
+        inputRecorder_->Record(eventType, eventData, mousePos, mouseVisible);
+    }
+
+    return true;
+}
+
+void UI::ReplayInput()
+{
+    // End the replay on the frame after the last events, so that the cost of handling them gets recorded
+    if (inputRecorder_->IsReplayFinished())
+    {
+        EndInputReplay();
+        return;
+    }
+
+    dispatchingReplay_ = true;
+
+    // The event is copied, as a handler may end the replay and clear the event list
+    RecordedUIInput input;
+    while (inputRecorder_->GetNextReplayEvent(input))
+    {
+        StringHash eventType = input.eventType_;
+        VariantMap& eventData = input.eventData_;
+
+        if (eventType == E_MOUSEBUTTONDOWN)
+            HandleMouseButtonDown(eventType, eventData);
+        else if (eventType == E_MOUSEBUTTONUP)
+            HandleMouseButtonUp(eventType, eventData);
+        else if (eventType == E_MOUSEMOVE)
+            HandleMouseMove(eventType, eventData);
+        else if (eventType == E_MOUSEWHEEL)
+            HandleMouseWheel(eventType, eventData);
+        else if (eventType == E_TOUCHBEGIN)
+            HandleTouchBegin(eventType, eventData);
+        else if (eventType == E_TOUCHEND)
+            HandleTouchEnd(eventType, eventData);
+        else if (eventType == E_TOUCHMOVE)
+            HandleTouchMove(eventType, eventData);
+        else if (eventType == E_KEYDOWN)
+            HandleKeyDown(eventType, eventData);
+        else if (eventType == E_CHAR)
+            HandleChar(eventType, eventData);
+        else if (eventType == E_DROPFILE)
+            HandleDropFile(eventType, eventData);
+    }
+
+    dispatchingReplay_ = false;
+}
+
+bool UI::GetMousePositionAndVisible(IntVector2& pos, bool& visible) const
+{
+    if (inputRecorder_->IsReplaying())
+    {
+        pos = inputRecorder_->GetReplayMousePosition();
+        visible = inputRecorder_->IsReplayMouseVisible();
+        return true;
+    }
+
+    Input* input = GetSubsystem<Input>();
+    if (!input)
+        return false;
+
+    pos = input->GetMousePosition();
+    visible = input->IsMouseVisible();
+    return true;
+}
+
+void UI::SetFontTextureImages()
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    if (!cache || !softwareRenderer_)
+        return;
+
+    PODVector<Resource*> fonts;
+    cache->GetResources(fonts, Font::GetTypeStatic());
+    if (compositionFont_ && !fonts.Contains(compositionFont_.Get()))
+        fonts.Push(compositionFont_.Get());
+
+    for (unsigned i = 0; i < fonts.Size(); ++i)
+    {
+        const HashMap<int, SharedPtr<FontFace> >& faces = static_cast<Font*>(fonts[i])->GetFaces();
+        for (HashMap<int, SharedPtr<FontFace> >::ConstIterator j = faces.Begin(); j != faces.End(); ++j)
+        {
+            FontFace* face = j->second_;
+            for (unsigned k = 0; k < face->images_.Size() && k < face->textures_.Size(); ++k)
+                softwareRenderer_->SetTextureImage(face->textures_[k], face->images_[k]);
+        }
+    }
 }
 
 void UI::HandleScreenMode(StringHash eventType, VariantMap& eventData)
@@ -987,6 +2085,7 @@ void UI::HandleScreenMode(StringHash eventType, VariantMap& eventData)
         Initialize();
     else
     {
+        // Resize the root right away, so that the new size is seen in the same frame
         rootElement_->SetSize(eventData[P_WIDTH].GetInt(), eventData[P_HEIGHT].GetInt());
         rootModalElement_->SetSize(rootElement_->GetSize());
     }
@@ -994,6 +2093,10 @@ void UI::HandleScreenMode(StringHash eventType, VariantMap& eventData)
 
 void UI::HandleMouseButtonDown(StringHash eventType, VariantMap& eventData)
 {
+    UIAllocationScope allocationScope(frameStats_.inputAllocations_, frameStats_.inputAllocatedBytes_);
+    if (!FilterInput(eventType, eventData))
+        return;
+
     mouseButtons_ = eventData[MouseButtonDown::P_BUTTONS].GetInt();
     qualifiers_ = eventData[MouseButtonDown::P_QUALIFIERS].GetInt();
     usingTouchInput_ = false;
@@ -1007,6 +2110,10 @@ void UI::HandleMouseButtonDown(StringHash eventType, VariantMap& eventData)
 
 void UI::HandleMouseButtonUp(StringHash eventType, VariantMap& eventData)
 {
+    UIAllocationScope allocationScope(frameStats_.inputAllocations_, frameStats_.inputAllocatedBytes_);
+    if (!FilterInput(eventType, eventData))
+        return;
+
     using namespace MouseButtonUp;
 
     mouseButtons_ = eventData[P_BUTTONS].GetInt();
@@ -1021,18 +2128,24 @@ void UI::HandleMouseButtonUp(StringHash eventType, VariantMap& eventData)
 
 void UI::HandleMouseMove(StringHash eventType, VariantMap& eventData)
 {
+    UIAllocationScope allocationScope(frameStats_.inputAllocations_, frameStats_.inputAllocatedBytes_);
+    if (!FilterInput(eventType, eventData))
+        return;
+
     using namespace MouseMove;
 
     mouseButtons_ = eventData[P_BUTTONS].GetInt();
     qualifiers_ = eventData[P_QUALIFIERS].GetInt();
     usingTouchInput_ = false;
 
-    Input* input = GetSubsystem<Input>();
+    IntVector2 mousePos;
+    bool mouseVisible;
+    bool hasMouse = GetMousePositionAndVisible(mousePos, mouseVisible);
     const IntVector2& rootSize = rootElement_->GetSize();
 
     if (cursor_)
     {
-        if (!input->IsMouseVisible())
+        if (hasMouse && !mouseVisible)
         {
             // Relative mouse motion: move cursor only when visible
             if (cursor_->IsVisible())
@@ -1061,6 +2174,10 @@ void UI::HandleMouseMove(StringHash eventType, VariantMap& eventData)
 
 void UI::HandleMouseWheel(StringHash eventType, VariantMap& eventData)
 {
+    UIAllocationScope allocationScope(frameStats_.inputAllocations_, frameStats_.inputAllocatedBytes_);
+    if (!FilterInput(eventType, eventData))
+        return;
+
     using namespace MouseWheel;
 
     mouseButtons_ = eventData[P_BUTTONS].GetInt();
@@ -1105,10 +2222,13 @@ void UI::HandleMouseWheel(StringHash eventType, VariantMap& eventData)
 
 void UI::HandleTouchBegin(StringHash eventType, VariantMap& eventData)
 {
+    UIAllocationScope allocationScope(frameStats_.inputAllocations_, frameStats_.inputAllocatedBytes_);
+    if (!FilterInput(eventType, eventData))
+        return;
+
     using namespace TouchBegin;
 
     IntVector2 pos(eventData[P_X].GetInt(), eventData[P_Y].GetInt());
-    WeakPtr<UIElement> element(GetElementAt(pos));
     usingTouchInput_ = true;
 
     ProcessClickBegin(pos, MOUSEB_LEFT, MOUSEB_LEFT, 0, 0, true);
@@ -1116,6 +2236,10 @@ void UI::HandleTouchBegin(StringHash eventType, VariantMap& eventData)
 
 void UI::HandleTouchEnd(StringHash eventType, VariantMap& eventData)
 {
+    UIAllocationScope allocationScope(frameStats_.inputAllocations_, frameStats_.inputAllocatedBytes_);
+    if (!FilterInput(eventType, eventData))
+        return;
+
     using namespace TouchEnd;
 
     IntVector2 pos(eventData[P_X].GetInt(), eventData[P_Y].GetInt());
@@ -1130,6 +2254,10 @@ void UI::HandleTouchEnd(StringHash eventType, VariantMap& eventData)
 
 void UI::HandleTouchMove(StringHash eventType, VariantMap& eventData)
 {
+    UIAllocationScope allocationScope(frameStats_.inputAllocations_, frameStats_.inputAllocatedBytes_);
+    if (!FilterInput(eventType, eventData))
+        return;
+
     using namespace TouchMove;
 
     IntVector2 pos(eventData[P_X].GetInt(), eventData[P_Y].GetInt());
@@ -1140,6 +2268,10 @@ void UI::HandleTouchMove(StringHash eventType, VariantMap& eventData)
 
 void UI::HandleKeyDown(StringHash eventType, VariantMap& eventData)
 {
+    UIAllocationScope allocationScope(frameStats_.inputAllocations_, frameStats_.inputAllocatedBytes_);
+    if (!FilterInput(eventType, eventData))
+        return;
+
     using namespace KeyDown;
 
     mouseButtons_ = eventData[P_BUTTONS].GetInt();
@@ -1205,6 +2337,10 @@ void UI::HandleKeyDown(StringHash eventType, VariantMap& eventData)
 
 void UI::HandleChar(StringHash eventType, VariantMap& eventData)
 {
+    UIAllocationScope allocationScope(frameStats_.inputAllocations_, frameStats_.inputAllocatedBytes_);
+    if (!FilterInput(eventType, eventData))
+        return;
+
     using namespace Char;
 
     mouseButtons_ = eventData[P_BUTTONS].GetInt();
@@ -1229,12 +2365,16 @@ void UI::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
 
 void UI::HandleDropFile(StringHash eventType, VariantMap& eventData)
 {
-    Input* input = GetSubsystem<Input>();
+    UIAllocationScope allocationScope(frameStats_.inputAllocations_, frameStats_.inputAllocatedBytes_);
+    if (!FilterInput(eventType, eventData))
+        return;
+
+    IntVector2 screenPos;
+    bool mouseVisible;
     
     // Sending the UI variant of the event only makes sense if the OS cursor is visible (not locked to window center)
-    if (input->IsMouseVisible())
+    if (GetMousePositionAndVisible(screenPos, mouseVisible) && mouseVisible)
     {
-        IntVector2 screenPos = input->GetMousePosition();
         UIElement* element = GetElementAt(screenPos);
         
         using namespace UIDropFile;
@@ -1253,6 +2393,7 @@ void UI::HandleDropFile(StringHash eventType, VariantMap& eventData)
         }
         
         SendEvent(E_UIDROPFILE, uiEventData);
+        ++frameStats_.eventsSent_;
     }
 }
 
@@ -24,20 +24,102 @@
 
 #include "Object.h"
 #include "Cursor.h"
+#include "GlyphRunCache.h"
 #include "UIBatch.h"
+#include "UIBinding.h"
+#include "UICommandBuffer.h"
+#include "UIEventDelegate.h"
+#include "UIInputRecorder.h"
+#include "UITaskScheduler.h"
+
+struct SDL_Cursor;
 
 namespace Urho3D
 {
 
 class Cursor;
+class Font;
 class Graphics;
+class Image;
 class ResourceCache;
+class Texture;
+class TextEditBuffer;
 class Timer;
 class UIBatch;
 class UIElement;
 class VertexBuffer;
 class XMLElement;
 class XMLFile;
+class UIAnimator;
+class UIElementIndex;
+class UISoftwareRenderer;
+
+/// Input method composition string changed.
+EVENT(E_UICOMPOSITION, UIComposition)
+{
+    PARAM(P_ELEMENT, Element);              // UIElement pointer
+    PARAM(P_TEXT, Text);                    // String
+    PARAM(P_CURSOR, Cursor);                // int
+}
+
+/// %UI frame statistics.
+struct URHO3D_API UIFrameStats
+{
+    /// Construct with all counters zero.
+    UIFrameStats();
+
+    /// Reset all counters to zero.
+    void Reset();
+
+    /// UI elements visited during logic update and batch generation.
+    unsigned elementsVisited_;
+    /// Rendering batches generated.
+    unsigned batches_;
+    /// Draw calls issued.
+    unsigned drawCalls_;
+    /// Vertices generated.
+    unsigned vertices_;
+    /// Vertex data bytes uploaded to vertex buffers.
+    unsigned uploadedBytes_;
+    /// Element hit tests.
+    unsigned hitTests_;
+    /// UI events sent.
+    unsigned eventsSent_;
+    /// Glyphs that had to be rendered to a font texture.
+    unsigned glyphMisses_;
+    /// Scheduled task steps run.
+    unsigned tasksRun_;
+    /// Scheduled tasks left waiting at the end of the update.
+    unsigned taskBacklog_;
+    /// Time spent running scheduled tasks in microseconds.
+    unsigned taskTime_;
+    /// Time spent in the logic update in microseconds.
+    unsigned updateTime_;
+    /// Time spent generating batches in microseconds.
+    unsigned renderUpdateTime_;
+    /// Time spent rendering in microseconds.
+    unsigned renderTime_;
+    /// Heap allocations during the logic update. Counted only when allocation tracking is installed, see UIAllocationScope.
+    unsigned updateAllocations_;
+    /// Heap bytes allocated during the logic update.
+    unsigned updateAllocatedBytes_;
+    /// Heap allocations during batch generation.
+    unsigned renderUpdateAllocations_;
+    /// Heap bytes allocated during batch generation.
+    unsigned renderUpdateAllocatedBytes_;
+    /// Heap allocations during rendering.
+    unsigned renderAllocations_;
+    /// Heap bytes allocated during rendering.
+    unsigned renderAllocatedBytes_;
+    /// Heap allocations during input handling.
+    unsigned inputAllocations_;
+    /// Heap bytes allocated during input handling.
+    unsigned inputAllocatedBytes_;
+    /// Heap allocations while rendering glyphs to font textures. Also included in the phase that needed the glyphs.
+    unsigned glyphAllocations_;
+    /// Heap bytes allocated while rendering glyphs to font textures.
+    unsigned glyphAllocatedBytes_;
+};
 
 /// %UI subsystem. Manages the graphical user interface.
 class URHO3D_API UI : public Object
@@ -63,12 +145,18 @@ public:
     void Clear();
     /// Update the UI logic. Called by HandlePostUpdate().
     void Update(float timeStep);
-    /// Update the UI for rendering. Called by HandleRenderUpdate().
+    /// Update the UI for rendering. Called by HandleRenderUpdate(). Can also be called without graphics and input subsystems.
     void RenderUpdate();
-    /// Render the UI.
+    /// Render the UI. Without graphics only completes the frame statistics.
     void Render();
     /// Debug draw a UI element.
     void DebugDraw(UIElement* element);
+    /// Rasterize the current batches into an image on the CPU, without the graphics device. Call after RenderUpdate(). The image is resized to the root element size. Without a graphics device, frame events do not drive the UI, so the batches are built here and font textures are read from the font faces' images. Return true if successful.
+    bool RenderToImage(Image* image, const Color& clearColor = Color(0.0f, 0.0f, 0.0f, 0.0f));
+    /// Set pixel data of a texture for software rendering, used instead of reading the texture back from the graphics device. A null image removes.
+    void SetSoftwareTextureImage(Texture* texture, Image* image);
+    /// Set root element size when there is no graphics device, for rendering to images. Enables software rendering, so call before loading fonts. Ignored once initialized with a graphics device, which sets the size from the screen.
+    void SetHeadlessSize(const IntVector2& size);
     /// Load a UI layout from an XML file. Optionally specify another XML file for element style. Return the root element.
     SharedPtr<UIElement> LoadLayout(Deserializer& source, XMLFile* styleFile = 0);
     /// Load a UI layout from an XML file. Optionally specify another XML file for element style. Return the root element.
@@ -83,6 +171,84 @@ public:
     void SetNonFocusedMouseWheel(bool nonFocusedMouseWheel);
     /// Set whether to use system clipboard. Default false.
     void SetUseSystemClipBoard(bool enable);
+    /// Set text of many Text or LineEdit elements at once. Layout updates of their parents are done once at the end.
+    void SetTexts(const PODVector<UIElement*>& elements, const Vector<String>& texts);
+    /// Set position of many elements at once. Layout updates of their parents are done once at the end.
+    void SetPositions(const PODVector<UIElement*>& elements, const PODVector<IntVector2>& positions);
+    /// Queue a text change of a Text or LineEdit element, to be applied before the next rendering update.
+    void QueueSetText(UIElement* element, const String& text);
+    /// Queue a position change, to be applied before the next rendering update.
+    void QueueSetPosition(UIElement* element, const IntVector2& position);
+    /// Queue a color change, to be applied before the next rendering update.
+    void QueueSetColor(UIElement* element, const Color& color);
+    /// Queue a visibility change, to be applied before the next rendering update.
+    void QueueSetVisible(UIElement* element, bool visible);
+    /// Queue an opacity change, to be applied before the next rendering update.
+    void QueueSetOpacity(UIElement* element, float opacity);
+    /// Apply the queued commands now. Called by RenderUpdate().
+    void ApplyCommands();
+    /// Defer layout updates of an element until the next rendering update. Use when adding many children or changing many child sizes.
+    void DeferLayout(UIElement* element);
+    /// Run the deferred layout updates now. Called by RenderUpdate(). Call explicitly when sizes are needed immediately.
+    void FlushLayouts();
+    /// Set whether to build the rendering batches on a worker thread between RenderUpdate() and Render(), overlapping scene rendering. The UI subsystem's own functions wait for the build first; elements modified directly must not be touched in between. Has no effect without worker threads. Default false.
+    void SetPipelinedBatching(bool enable);
+    /// Set whether to fail every frame that makes heap allocations during update, batch generation, rendering or input handling. A failing frame logs an error and asserts, and is counted in the allocation check failures. Enable after warming up to check that steady-state frames do not allocate. Requires allocation tracking, see UIAllocationScope. Return false and leave the check disabled if allocations are not being counted.
+    bool SetAllocationCheck(bool enable);
+    /// Build the rendering batches into the back buffers. Called by the worker thread when pipelined batching is enabled.
+    void BuildPendingBatches();
+    /// Set whether to coalesce drag moves to one per frame, so that for example window resizing lays out once per frame. Default true.
+    void SetCoalesceDragMoves(bool enable);
+    /// Schedule a task. Higher priority tasks run first, tasks of the same priority in order of scheduling.
+    void AddTask(UITask* task, int priority = 0);
+    /// Remove a scheduled task.
+    void RemoveTask(UITask* task);
+    /// Remove all scheduled tasks.
+    void RemoveAllTasks();
+    /// Set time budget in milliseconds for running scheduled tasks each frame. Each task runs at most once per frame. Zero runs every task once without a time limit.
+    void SetTaskBudget(float budget);
+    /// Bind an element attribute to an observable value. The attribute is set before rendering whenever the value has changed.
+    void Bind(UIElement* element, const String& attribute, UIObservable* observable);
+    /// Remove the binding of an element attribute.
+    void Unbind(UIElement* element, const String& attribute);
+    /// Remove all bindings of an element.
+    void UnbindAll(UIElement* element);
+    /// Apply changed bound values now. Called by RenderUpdate().
+    void ApplyBindings();
+    /// Set delegate to invoke when an element is clicked. Null removes.
+    void SetClickDelegate(UIElement* element, UIEventDelegate* delegate);
+    /// Set delegate to invoke when a click ends on an element. Null removes.
+    void SetClickEndDelegate(UIElement* element, UIEventDelegate* delegate);
+    /// Add a tag to an element.
+    void AddTag(UIElement* element, const String& tag);
+    /// Remove a tag from an element.
+    void RemoveTag(UIElement* element, const String& tag);
+    /// Remove all tags from an element.
+    void RemoveAllTags(UIElement* element);
+    /// Define an OS hardware cursor for a cursor shape from an image rectangle. A zero rectangle uses the whole image. Return true if successful.
+    bool DefineHardwareCursorShape(CursorShape shape, Image* image, const IntRect& imageRect, const IntVector2& hotSpot);
+    /// Set whether to show the cursor element's shapes as OS hardware cursors, which follow the mouse without a frame of latency. Requires at least the normal shape to be defined. Shapes without a hardware cursor are rendered by the cursor element. Return true if hardware cursor is in use.
+    bool SetHardwareCursor(bool enable);
+    /// Set the in-progress input method composition string and the cursor position within it in characters. The string is drawn as an overlay at the composition position and does not modify the focused element until committed. An empty string ends the composition.
+    void SetCompositionText(const String& text, unsigned cursor = M_MAX_UNSIGNED);
+    /// Set screen position of the composition overlay, usually the text caret of the focused editor.
+    void SetCompositionPosition(const IntVector2& position);
+    /// Set font and size of the composition overlay.
+    void SetCompositionFont(Font* font, int size);
+    /// Set color of the composition overlay.
+    void SetCompositionColor(const Color& color);
+    /// Set the text editing buffer of an editor element. Committed text is then inserted into the buffer as one edit while the element has focus. Null clears.
+    void SetTextEditBuffer(UIElement* element, TextEditBuffer* buffer);
+    /// Deliver committed text to the focused element in one call and end the composition. Use for multi-character commits, such as from an input method. An element with a text editing buffer receives it as one insert and one text changed event, others as characters.
+    void CommitText(const String& text);
+    /// Begin recording the input events handled by the UI to a file, along with the root size and mouse state they depend on. Return true if successful.
+    bool BeginInputRecording(const String& fileName);
+    /// End input recording.
+    void EndInputRecording();
+    /// Begin replaying recorded input events from a file. Restores the recorded root size and cursor position, and ignores live input during the replay. Return true if successful.
+    bool BeginInputReplay(const String& fileName);
+    /// End input replay. The frame statistics of the replay remain available.
+    void EndInputReplay();
 
     /// Return root UI element.
     UIElement* GetRoot() const { return rootElement_; }
@@ -96,6 +262,18 @@ public:
     UIElement* GetElementAt(const IntVector2& position, bool enabledOnly = true);
     /// Return UI element at screen coordinates.
     UIElement* GetElementAt(int x, int y, bool enabledOnly = true);
+    /// Return element by name from the root and modal root hierarchies. Found elements are indexed, so repeated lookups are fast.
+    UIElement* FindElement(const String& name);
+    /// Return click delegate of an element.
+    UIEventDelegate* GetClickDelegate(UIElement* element) const;
+    /// Return click end delegate of an element.
+    UIEventDelegate* GetClickEndDelegate(UIElement* element) const;
+    /// Return the text editing buffer of an editor element, or null if none.
+    TextEditBuffer* GetTextEditBuffer(UIElement* element) const;
+    /// Return whether an element has a tag.
+    bool HasTag(UIElement* element, const String& tag) const;
+    /// Return elements with a tag.
+    PODVector<UIElement*> GetElementsWithTag(const String& tag);
     /// Return focused element.
     UIElement* GetFocusElement() const { return focusElement_; }
     /// Return topmost enabled root-level non-modal element.
@@ -110,6 +288,54 @@ public:
     bool GetUseSystemClipBoard() const { return useSystemClipBoard_; }
     /// Return true when UI has modal element(s).
     bool HasModalElement() const;
+    /// Return whether hardware cursor is in use.
+    bool IsHardwareCursor() const { return hardwareCursor_; }
+    /// Return whether the UI renders in software. Without a graphics device fonts load and create font faces only then.
+    bool IsSoftwareRendering() const { return softwareRenderer_.NotNull(); }
+    /// Return the input method composition string.
+    const String& GetCompositionText() const { return compositionText_; }
+    /// Return cursor position within the composition string in characters.
+    unsigned GetCompositionCursor() const { return compositionCursor_; }
+    /// Return screen position of the composition overlay.
+    const IntVector2& GetCompositionPosition() const { return compositionPosition_; }
+    /// Return font of the composition overlay.
+    Font* GetCompositionFont() const { return compositionFont_; }
+    /// Return font size of the composition overlay.
+    int GetCompositionFontSize() const { return compositionFontSize_; }
+    /// Return color of the composition overlay.
+    const Color& GetCompositionColor() const { return compositionColor_; }
+    /// Return whether an input method composition is in progress.
+    bool IsComposing() const { return !compositionChars_.Empty(); }
+    /// Return the tween animator, which is updated with the UI logic.
+    UIAnimator* GetAnimator() const { return animator_; }
+    /// Return statistics of the last completed frame.
+    const UIFrameStats& GetFrameStats() const { return lastFrameStats_; }
+    /// Return per-frame time budget for scheduled tasks in milliseconds.
+    float GetTaskBudget() const { return taskScheduler_->GetBudget(); }
+    /// Return number of scheduled tasks.
+    unsigned GetTaskBacklog() const { return taskScheduler_->GetNumTasks(); }
+    /// Return number of frames in which running tasks exceeded the budget.
+    unsigned GetTaskBudgetOverruns() const { return taskScheduler_->GetBudgetOverruns(); }
+    /// Return whether batches are built on a worker thread.
+    bool GetPipelinedBatching() const { return pipelinedBatching_; }
+    /// Return whether the steady-state allocation check is enabled.
+    bool GetAllocationCheck() const { return allocationCheck_; }
+    /// Return number of frames that failed the allocation check.
+    unsigned GetAllocationCheckFailures() const { return allocationCheckFailures_; }
+    /// Return whether drag moves are coalesced to one per frame.
+    bool GetCoalesceDragMoves() const { return coalesceDragMoves_; }
+    /// Return number of elements with deferred layout updates.
+    unsigned GetNumDeferredLayouts() const { return deferredLayouts_.Size(); }
+    /// Return number of bindings.
+    unsigned GetNumBindings() const { return binder_->GetNumBindings(); }
+    /// Return number of queued commands.
+    unsigned GetNumQueuedCommands() const { return commandBuffer_->GetNumCommands(); }
+    /// Return whether input is being recorded.
+    bool IsRecordingInput() const { return inputRecorder_->IsRecording(); }
+    /// Return whether recorded input is being replayed.
+    bool IsReplayingInput() const { return inputRecorder_->IsReplaying(); }
+    /// Return statistics of each frame of the last input replay.
+    const PODVector<UIFrameStats>& GetReplayFrameStats() const { return replayFrameStats_; }
 
 private:
     /// Initialize when screen mode initially se.
@@ -120,8 +346,14 @@ private:
     void SetVertexData(VertexBuffer* dest, const PODVector<float>& vertexData);
     /// Render UI batches. Geometry must have been uploaded first.
     void Render(VertexBuffer* buffer, const PODVector<UIBatch>& batches, unsigned batchStart, unsigned batchEnd);
+    /// Generate batches from all UI elements and the cursor.
+    void BuildBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, unsigned& nonModalBatchSize);
+    /// Wait for the worker thread batch build and swap its results to the front buffers.
+    void CompleteBatchBuild();
     /// Generate batches from an UI element recursively. Skip the cursor element.
-    void GetBatches(UIElement* element, IntRect currentScissor);
+    void GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, UIElement* element, IntRect currentScissor);
+    /// Generate batches for the input method composition overlay.
+    void GetCompositionBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor);
     /// Return UI element at screen position recursively.
     void GetElementAt(UIElement*& result, UIElement* current, const IntVector2& position, bool enabledOnly);
     /// Return the first element in hierarchy that can alter focus.
@@ -130,16 +362,32 @@ private:
     void GetCursorPositionAndVisible(IntVector2& pos, bool& visible);
     /// Set active cursor's shape.
     void SetCursorShape(CursorShape shape);
+    /// Show the hardware cursor matching the cursor element's shape, or hide the OS cursor if the shape has none.
+    void UpdateHardwareCursor();
     /// Handle button or touch begin.
     void ProcessClickBegin(const IntVector2& cursorPos, int button, int buttons, int qualifiers, Cursor* cursor, bool cursorVisible);
     /// Handle button or touch end.
     void ProcessClickEnd(const IntVector2& cursorPos, int button, int buttons, int qualifiers, Cursor* cursor, bool cursorVisible);
     /// Handle mouse or touch move.
     void ProcessMove(const IntVector2& cursorPos, int buttons, int qualifiers, Cursor* cursor, bool cursorVisible);
+    /// Handle drag move of the element being dragged.
+    void ProcessDragMove(const IntVector2& cursorPos, int buttons, int qualifiers, Cursor* cursor);
+    /// Handle a pending coalesced drag move.
+    void FlushDragMove();
     /// Send a UI element drag event.
     void SendDragEvent(StringHash eventType, UIElement* element, const IntVector2& screenPos);
     /// Send a UI click or double click event.
     void SendClickEvent(StringHash eventType, UIElement* element, const IntVector2& pos, int button, int buttons, int qualifiers);
+    /// Publish the statistics of the frame in progress and start collecting the next.
+    void EndFrameStats();
+    /// Record an input event if recording, and return whether it should be handled.
+    bool FilterInput(StringHash eventType, VariantMap& eventData);
+    /// Dispatch the recorded input events of the current frame.
+    void ReplayInput();
+    /// Return the operating system mouse position and visibility, or the recorded values when replaying input. Return false if not available.
+    bool GetMousePositionAndVisible(IntVector2& pos, bool& visible) const;
+    /// Pass the pixels of font textures kept on the CPU to the software renderer.
+    void SetFontTextureImages();
     /// Handle screen mode event.
     void HandleScreenMode(StringHash eventType, VariantMap& eventData);
     /// Handle mouse button down event.
@@ -205,6 +453,94 @@ private:
     SharedPtr<VertexBuffer> debugVertexBuffer_;
     /// UI element query vector.
     PODVector<UIElement*> tempElements_;
+    /// Bulk updates and queued commands.
+    SharedPtr<UICommandBuffer> commandBuffer_;
+    /// Rendering batches built on the worker thread.
+    PODVector<UIBatch> buildBatches_;
+    /// Vertex data built on the worker thread.
+    PODVector<float> buildVertexData_;
+    /// Non-modal batch size built on the worker thread.
+    unsigned buildNonModalBatchSize_;
+    /// Time of the worker thread build in microseconds.
+    unsigned buildTime_;
+    /// Elements visited by the last batch build.
+    unsigned buildElementsVisited_;
+    /// Whether to build the cursor element's batches.
+    bool buildCursorBatches_;
+    /// Pipelined batching flag.
+    bool pipelinedBatching_;
+    /// Worker thread batch build in progress flag.
+    bool batchBuildPending_;
+    /// Worker thread batch build finished flag. Set by the worker thread.
+    volatile bool batchBuildFinished_;
+    /// Elements with deferred layout updates.
+    Vector<WeakPtr<UIElement> > deferredLayouts_;
+    /// Coalesce drag moves flag.
+    bool coalesceDragMoves_;
+    /// Coalesced drag move pending flag.
+    bool dragMovePending_;
+    /// Position of the pending drag move.
+    IntVector2 dragMovePosition_;
+    /// Mouse buttons of the pending drag move.
+    int dragMoveButtons_;
+    /// Qualifier keys of the pending drag move.
+    int dragMoveQualifiers_;
+    /// Cursor of the pending drag move.
+    WeakPtr<Cursor> dragMoveCursor_;
+    /// Hardware cursors by shape.
+    SDL_Cursor* hardwareCursors_[CS_MAX_SHAPES];
+    /// Cursor shape being shown while the hardware cursor is in use. Shown by the cursor element if it has no hardware cursor.
+    CursorShape hardwareCursorShape_;
+    /// Hardware cursor in use flag.
+    bool hardwareCursor_;
+    /// OS mouse visibility before hardware cursor was enabled.
+    bool mouseVisibleBeforeHardwareCursor_;
+    /// Input method composition string.
+    String compositionText_;
+    /// Decoded characters of the composition string.
+    PODVector<unsigned> compositionChars_;
+    /// Cursor position within the composition string.
+    unsigned compositionCursor_;
+    /// Screen position of the composition overlay.
+    IntVector2 compositionPosition_;
+    /// Composition position set flag. When not set, the overlay is drawn at the focused element.
+    bool compositionPositionSet_;
+    /// Font of the composition overlay.
+    SharedPtr<Font> compositionFont_;
+    /// Font size of the composition overlay.
+    int compositionFontSize_;
+    /// Color of the composition overlay.
+    Color compositionColor_;
+    /// Cached glyph quads of the composition overlay.
+    GlyphRunCache compositionRun_;
+    /// Character positions of the composition overlay.
+    PODVector<IntVector2> compositionPositions_;
+    /// Width of the composition overlay.
+    int compositionWidth_;
+    /// Cursor position within the composition overlay.
+    int compositionCursorX_;
+    /// Tween animator.
+    SharedPtr<UIAnimator> animator_;
+    /// Software renderer, created on first use.
+    SharedPtr<UISoftwareRenderer> softwareRenderer_;
+    /// Data bindings.
+    SharedPtr<UIBinder> binder_;
+    /// Scheduled tasks.
+    SharedPtr<UITaskScheduler> taskScheduler_;
+    /// Steady-state allocation check flag.
+    bool allocationCheck_;
+    /// Number of frames that failed the allocation check.
+    unsigned allocationCheckFailures_;
+    /// Heap allocations of the batch build, possibly on the worker thread.
+    unsigned buildAllocations_;
+    /// Heap bytes allocated by the batch build.
+    unsigned buildAllocatedBytes_;
+    /// Click delegates.
+    UIDelegateMap clickDelegates_;
+    /// Click end delegates.
+    UIDelegateMap clickEndDelegates_;
+    /// Element name and tag index.
+    SharedPtr<UIElementIndex> elementIndex_;
     /// Clipboard text.
     mutable String clipBoard_;
     /// Mouse buttons held down.
@@ -231,6 +567,24 @@ private:
     int lastMouseButtons_;
     /// Seconds between clicks to register a double click.
     float doubleClickInterval_;
+    /// Statistics of the frame in progress.
+    UIFrameStats frameStats_;
+    /// Statistics of the last completed frame.
+    UIFrameStats lastFrameStats_;
+    /// Font face glyph miss count at the end of the previous frame.
+    unsigned lastGlyphMisses_;
+    /// Font face glyph miss allocation count at the end of the previous frame.
+    unsigned lastGlyphAllocations_;
+    /// Font face glyph miss allocated bytes at the end of the previous frame.
+    unsigned lastGlyphAllocatedBytes_;
+    /// Statistics of each frame of the input replay.
+    PODVector<UIFrameStats> replayFrameStats_;
+    /// Input recording and replay.
+    SharedPtr<UIInputRecorder> inputRecorder_;
+    /// Time in milliseconds of the last replayed click that may begin a double click.
+    unsigned replayClickTime_;
+    /// Replayed input dispatch in progress flag.
+    bool dispatchingReplay_;
 };
 
 /// Register UI library objects.
@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "UIAllocation.h"
+
+#include "DebugNew.h"
+
+#if defined(_MSC_VER)
+#define UI_THREAD_LOCAL __declspec(thread)
+#else
+#define UI_THREAD_LOCAL __thread
+#endif
+
+namespace Urho3D
+{
+
+/// Heap allocations made by the current thread.
+static UI_THREAD_LOCAL unsigned threadAllocations = 0;
+/// Heap bytes allocated by the current thread.
+static UI_THREAD_LOCAL unsigned threadBytes = 0;
+/// Whether the application's operator new counts allocations.
+static volatile bool countingEnabled = false;
+
+UIAllocationScope::UIAllocationScope() :
+    allocations_(0),
+    bytes_(0),
+    startAllocations_(threadAllocations),
+    startBytes_(threadBytes)
+{
+}
+
+UIAllocationScope::UIAllocationScope(unsigned& allocations, unsigned& bytes) :
+    allocations_(&allocations),
+    bytes_(&bytes),
+    startAllocations_(threadAllocations),
+    startBytes_(threadBytes)
+{
+}
+
+UIAllocationScope::~UIAllocationScope()
+{
+    if (allocations_)
+        *allocations_ += GetAllocations();
+    if (bytes_)
+        *bytes_ += GetAllocatedBytes();
+}
+
+unsigned UIAllocationScope::GetAllocations() const
+{
+    return threadAllocations - startAllocations_;
+}
+
+unsigned UIAllocationScope::GetAllocatedBytes() const
+{
+    return threadBytes - startBytes_;
+}
+
+void UIAllocationScope::CountAllocation(unsigned size)
+{
+    ++threadAllocations;
+    threadBytes += size;
+    countingEnabled = true;
+}
+
+bool UIAllocationScope::IsEnabled()
+{
+    return countingEnabled;
+}
+
+}
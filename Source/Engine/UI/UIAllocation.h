@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <cstdlib>
+#include <new>
+
+namespace Urho3D
+{
+
+/// Adds the heap allocations made on the current thread during its lifetime to a pair of counters. Nested scopes each count their own allocations as well as those of inner scopes. Counting requires the application to install the allocation hooks with DEFINE_UI_ALLOCATION_TRACKING(), or to call CountAllocation() from its own operator new; otherwise the counters are left unchanged. As a shared engine library does not route its allocations through the application's operator new on all platforms, tracking requires a static engine library build.
+class URHO3D_API UIAllocationScope
+{
+public:
+    /// Construct and begin counting without counters to add to. The counts can be read while in scope.
+    UIAllocationScope();
+    /// Construct and begin counting.
+    UIAllocationScope(unsigned& allocations, unsigned& bytes);
+    /// Destruct and add the counted allocations.
+    ~UIAllocationScope();
+
+    /// Return allocations counted so far.
+    unsigned GetAllocations() const;
+    /// Return bytes allocated so far.
+    unsigned GetAllocatedBytes() const;
+
+    /// Count an allocation on the current thread. Called by the application's global operator new.
+    static void CountAllocation(unsigned size);
+    /// Return whether allocations are being counted, ie. CountAllocation() has been called.
+    static bool IsEnabled();
+
+private:
+    /// Prevent copy construction.
+    UIAllocationScope(const UIAllocationScope& rhs);
+    /// Prevent assignment.
+    UIAllocationScope& operator = (const UIAllocationScope& rhs);
+
+    /// Allocation counter to add to.
+    unsigned* allocations_;
+    /// Allocated bytes counter to add to.
+    unsigned* bytes_;
+    /// Thread allocation count at construction.
+    unsigned startAllocations_;
+    /// Thread allocated bytes at construction.
+    unsigned startBytes_;
+};
+
+}
+
+/// Define global operator new and delete that count allocations for UIAllocationScope. Expand once at global scope in an application source file that does not include DebugNew.h, and link the engine statically. Applications that replace operator new themselves call UIAllocationScope::CountAllocation() from it instead.
+#define DEFINE_UI_ALLOCATION_TRACKING() \
+void* operator new(size_t size) \
+{ \
+    Urho3D::UIAllocationScope::CountAllocation((unsigned)size); \
+    void* ptr = malloc(size ? size : 1); \
+    if (!ptr) \
+        throw std::bad_alloc(); \
+    return ptr; \
+} \
+void* operator new[](size_t size) \
+{ \
+    Urho3D::UIAllocationScope::CountAllocation((unsigned)size); \
+    void* ptr = malloc(size ? size : 1); \
+    if (!ptr) \
+        throw std::bad_alloc(); \
+    return ptr; \
+} \
+void* operator new(size_t size, const std::nothrow_t&) throw() \
+{ \
+    Urho3D::UIAllocationScope::CountAllocation((unsigned)size); \
+    return malloc(size ? size : 1); \
+} \
+void* operator new[](size_t size, const std::nothrow_t&) throw() \
+{ \
+    Urho3D::UIAllocationScope::CountAllocation((unsigned)size); \
+    return malloc(size ? size : 1); \
+} \
+void operator delete(void* ptr) throw() { free(ptr); } \
+void operator delete[](void* ptr) throw() { free(ptr); } \
+void operator delete(void* ptr, const std::nothrow_t&) throw() { free(ptr); } \
+void operator delete[](void* ptr, const std::nothrow_t&) throw() { free(ptr); }
@@ -0,0 +1,349 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "UIAnimator.h"
+#include "UIElement.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+static float GetPropertyValue(UIElement* element, TweenProperty property)
+{
+    switch (property)
+    {
+    case TP_OPACITY:
+        return element->GetOpacity();
+
+    case TP_POSITION_X:
+        return (float)element->GetPosition().x_;
+
+    case TP_POSITION_Y:
+        return (float)element->GetPosition().y_;
+
+    case TP_WIDTH:
+        return (float)element->GetWidth();
+
+    case TP_HEIGHT:
+        return (float)element->GetHeight();
+    }
+
+    return 0.0f;
+}
+
+static void SetPropertyValue(UIElement* element, TweenProperty property, float value)
+{
+    switch (property)
+    {
+    case TP_OPACITY:
+        element->SetOpacity(value);
+        break;
+
+    case TP_POSITION_X:
+        element->SetPosition((int)floorf(value + 0.5f), element->GetPosition().y_);
+        break;
+
+    case TP_POSITION_Y:
+        element->SetPosition(element->GetPosition().x_, (int)floorf(value + 0.5f));
+        break;
+
+    case TP_WIDTH:
+        element->SetWidth((int)floorf(value + 0.5f));
+        break;
+
+    case TP_HEIGHT:
+        element->SetHeight((int)floorf(value + 0.5f));
+        break;
+    }
+}
+
+static float Ease(EaseType ease, float t)
+{
+    switch (ease)
+    {
+    case EASE_IN_QUAD:
+        return t * t;
+
+    case EASE_OUT_QUAD:
+        return t * (2.0f - t);
+
+    case EASE_IN_OUT_QUAD:
+        return t < 0.5f ? 2.0f * t * t : -1.0f + (4.0f - 2.0f * t) * t;
+
+    case EASE_SMOOTHSTEP:
+        return t * t * (3.0f - 2.0f * t);
+
+    default:
+        return t;
+    }
+}
+
+UIAnimator::UIAnimator() :
+    nextId_(1),
+    updating_(false)
+{
+}
+
+UIAnimator::~UIAnimator()
+{
+}
+
+unsigned UIAnimator::Tween(UIElement* element, TweenProperty property, float to, float duration, EaseType ease, TweenLoopMode loopMode)
+{
+    if (!element)
+        return 0;
+
+    return Tween(element, property, GetPropertyValue(element, property), to, duration, ease, loopMode);
+}
+
+unsigned UIAnimator::Tween(UIElement* element, TweenProperty property, float from, float to, float duration, EaseType ease, TweenLoopMode loopMode)
+{
+    if (!element)
+        return 0;
+
+    // Replace an existing tween of the same property
+    for (unsigned i = 0; i < ids_.Size(); ++i)
+    {
+        if (elements_[i].Get() == element && properties_[i] == property)
+        {
+            Kill(i);
+            break;
+        }
+    }
+
+    unsigned id = nextId_++;
+    if (!nextId_)
+        nextId_ = 1;
+
+    elements_.Push(WeakPtr<UIElement>(element));
+    ids_.Push(id);
+    from_.Push(from);
+    to_.Push(to);
+    elapsed_.Push(0.0f);
+    invDuration_.Push(duration > 0.0f ? 1.0f / duration : 0.0f);
+    time_.Push(0.0f);
+    properties_.Push((unsigned char)property);
+    eases_.Push((unsigned char)ease);
+    loopModes_.Push((unsigned char)loopMode);
+
+    return id;
+}
+
+void UIAnimator::Stop(unsigned id)
+{
+    for (unsigned i = 0; i < ids_.Size(); ++i)
+    {
+        if (ids_[i] == id)
+        {
+            Kill(i);
+            return;
+        }
+    }
+}
+
+void UIAnimator::Stop(UIElement* element)
+{
+    for (unsigned i = ids_.Size() - 1; i < ids_.Size(); --i)
+    {
+        if (elements_[i].Get() == element)
+            Kill(i);
+    }
+}
+
+void UIAnimator::StopAll()
+{
+    if (updating_)
+    {
+        for (unsigned i = 0; i < ids_.Size(); ++i)
+            Kill(i);
+        return;
+    }
+
+    elements_.Clear();
+    ids_.Clear();
+    from_.Clear();
+    to_.Clear();
+    elapsed_.Clear();
+    invDuration_.Clear();
+    time_.Clear();
+    properties_.Clear();
+    eases_.Clear();
+    loopModes_.Clear();
+}
+
+void UIAnimator::Update(float timeStep)
+{
+    unsigned count = ids_.Size();
+    if (!count)
+        return;
+
+    // Advance all tweens to normalized time in one loop over the packed arrays, which the compiler can vectorize
+    float* elapsed = &elapsed_[0];
+    const float* invDuration = &invDuration_[0];
+    float* time = &time_[0];
+    for (unsigned i = 0; i < count; ++i)
+    {
+        elapsed[i] += timeStep;
+        // A zero inverse duration means an instant tween, which finishes immediately
+        time[i] = invDuration[i] > 0.0f ? elapsed[i] * invDuration[i] : 1.0f;
+    }
+
+    // Apply eased values, handling looping and completion. Setting the properties may send events whose handlers start
+    // or stop tweens, so access the arrays through the members from here on
+    finished_.Clear();
+    updating_ = true;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        UIElement* element = elements_[i];
+        if (!element)
+        {
+            finished_.Push(i);
+            continue;
+        }
+
+        float t = time_[i];
+        TweenLoopMode loopMode = (TweenLoopMode)loopModes_[i];
+        if (loopMode == TLM_LOOP)
+        {
+            if (t >= 1.0f && invDuration_[i] > 0.0f)
+            {
+                t -= floorf(t);
+                elapsed_[i] = t / invDuration_[i];
+            }
+        }
+        else if (loopMode == TLM_PINGPONG)
+        {
+            // A ping-pong cycle is two durations long, with the second half running backward
+            if (t >= 2.0f && invDuration_[i] > 0.0f)
+            {
+                t -= 2.0f * floorf(0.5f * t);
+                elapsed_[i] = t / invDuration_[i];
+            }
+            if (t > 1.0f)
+                t = 2.0f - t;
+        }
+
+        // Tweens played once, and repeating tweens of zero duration, finish at the end value
+        if (t >= 1.0f && (loopMode == TLM_ONCE || invDuration_[i] <= 0.0f))
+        {
+            t = 1.0f;
+            finished_.Push(i);
+        }
+
+        float value = Lerp(from_[i], to_[i], Ease((EaseType)eases_[i], t));
+        SetPropertyValue(element, (TweenProperty)properties_[i], value);
+    }
+    updating_ = false;
+
+    if (finished_.Empty())
+        return;
+
+    // Remove the finished tweens first, as completion event handlers may start or stop tweens. Removing from the back
+    // keeps the remaining indices valid
+    Vector<WeakPtr<UIElement> > finishedElements;
+    PODVector<unsigned> finishedIds;
+    PODVector<int> finishedProperties;
+    for (unsigned i = finished_.Size() - 1; i < finished_.Size(); --i)
+    {
+        unsigned index = finished_[i];
+        finishedElements.Push(elements_[index]);
+        finishedIds.Push(ids_[index]);
+        finishedProperties.Push(properties_[index]);
+        RemoveAt(index);
+    }
+
+    for (unsigned i = 0; i < finishedElements.Size(); ++i)
+    {
+        UIElement* element = finishedElements[i];
+        if (!element)
+            continue;
+
+        using namespace UITweenFinished;
+
+        VariantMap eventData;
+        eventData[P_ELEMENT] = (void*)element;
+        eventData[P_PROPERTY] = finishedProperties[i];
+        eventData[P_ID] = finishedIds[i];
+        element->SendEvent(E_UITWEENFINISHED, eventData);
+    }
+}
+
+bool UIAnimator::IsActive(unsigned id) const
+{
+    return id && ids_.Contains(id);
+}
+
+bool UIAnimator::IsAnimating(UIElement* element) const
+{
+    for (unsigned i = 0; i < elements_.Size(); ++i)
+    {
+        if (elements_[i].Get() == element)
+            return true;
+    }
+
+    return false;
+}
+
+void UIAnimator::Kill(unsigned index)
+{
+    // During the update only mark the tween, it will be removed as finished without a completion event
+    if (updating_)
+    {
+        elements_[index].Reset();
+        ids_[index] = 0;
+    }
+    else
+        RemoveAt(index);
+}
+
+void UIAnimator::RemoveAt(unsigned index)
+{
+    unsigned last = ids_.Size() - 1;
+    if (index != last)
+    {
+        elements_[index] = elements_[last];
+        ids_[index] = ids_[last];
+        from_[index] = from_[last];
+        to_[index] = to_[last];
+        elapsed_[index] = elapsed_[last];
+        invDuration_[index] = invDuration_[last];
+        time_[index] = time_[last];
+        properties_[index] = properties_[last];
+        eases_[index] = eases_[last];
+        loopModes_[index] = loopModes_[last];
+    }
+
+    elements_.Pop();
+    ids_.Pop();
+    from_.Pop();
+    to_.Pop();
+    elapsed_.Pop();
+    invDuration_.Pop();
+    time_.Pop();
+    properties_.Pop();
+    eases_.Pop();
+    loopModes_.Pop();
+}
+
+}
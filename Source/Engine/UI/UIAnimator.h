@@ -0,0 +1,131 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Object.h"
+
+namespace Urho3D
+{
+
+class UIElement;
+
+/// UI element property animated by a tween.
+enum TweenProperty
+{
+    TP_OPACITY = 0,
+    TP_POSITION_X,
+    TP_POSITION_Y,
+    TP_WIDTH,
+    TP_HEIGHT
+};
+
+/// Tween easing function.
+enum EaseType
+{
+    EASE_LINEAR = 0,
+    EASE_IN_QUAD,
+    EASE_OUT_QUAD,
+    EASE_IN_OUT_QUAD,
+    EASE_SMOOTHSTEP
+};
+
+/// Tween repeat mode.
+enum TweenLoopMode
+{
+    TLM_ONCE = 0,
+    TLM_LOOP,
+    TLM_PINGPONG
+};
+
+/// UI tween finished.
+EVENT(E_UITWEENFINISHED, UITweenFinished)
+{
+    PARAM(P_ELEMENT, Element);              // UIElement pointer
+    PARAM(P_PROPERTY, Property);            // int
+    PARAM(P_ID, ID);                        // unsigned
+}
+
+/// Animates UI element properties. Active tweens are stored in packed arrays and evaluated together each frame.
+class URHO3D_API UIAnimator : public RefCounted
+{
+public:
+    /// Construct.
+    UIAnimator();
+    /// Destruct.
+    virtual ~UIAnimator();
+
+    /// Start a tween from the current value of the property. An existing tween of the same element and property is replaced. Return tween ID, or 0 if failed.
+    unsigned Tween(UIElement* element, TweenProperty property, float to, float duration, EaseType ease = EASE_LINEAR, TweenLoopMode loopMode = TLM_ONCE);
+    /// Start a tween between two values. An existing tween of the same element and property is replaced. Return tween ID, or 0 if failed.
+    unsigned Tween(UIElement* element, TweenProperty property, float from, float to, float duration, EaseType ease = EASE_LINEAR, TweenLoopMode loopMode = TLM_ONCE);
+    /// Stop a tween by ID, leaving the property at its current value.
+    void Stop(unsigned id);
+    /// Stop all tweens of an element.
+    void Stop(UIElement* element);
+    /// Stop all tweens.
+    void StopAll();
+    /// Advance all tweens and apply the values. Called by the UI subsystem.
+    void Update(float timeStep);
+
+    /// Return number of active tweens.
+    unsigned GetNumTweens() const { return ids_.Size(); }
+    /// Return whether a tween is active.
+    bool IsActive(unsigned id) const;
+    /// Return whether an element has active tweens.
+    bool IsAnimating(UIElement* element) const;
+
+private:
+    /// Stop a tween by index. During the update the tween is only marked for removal.
+    void Kill(unsigned index);
+    /// Remove a tween by index, moving the last tween in its place.
+    void RemoveAt(unsigned index);
+
+    /// Elements.
+    Vector<WeakPtr<UIElement> > elements_;
+    /// Tween IDs.
+    PODVector<unsigned> ids_;
+    /// Start values.
+    PODVector<float> from_;
+    /// End values.
+    PODVector<float> to_;
+    /// Elapsed times.
+    PODVector<float> elapsed_;
+    /// Inverse durations.
+    PODVector<float> invDuration_;
+    /// Normalized times of the current frame.
+    PODVector<float> time_;
+    /// Properties.
+    PODVector<unsigned char> properties_;
+    /// Easing functions.
+    PODVector<unsigned char> eases_;
+    /// Repeat modes.
+    PODVector<unsigned char> loopModes_;
+    /// Indices of tweens finished during the update.
+    PODVector<unsigned> finished_;
+    /// Next tween ID.
+    unsigned nextId_;
+    /// Update in progress flag.
+    bool updating_;
+};
+
+}
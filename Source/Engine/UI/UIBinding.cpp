@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "Log.h"
+#include "Profiler.h"
+#include "UIBinding.h"
+#include "UIElement.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+UIBinder::UIBinder()
+{
+}
+
+UIBinder::~UIBinder()
+{
+}
+
+void UIBinder::Bind(UIElement* element, const String& attribute, UIObservable* observable)
+{
+    if (!element || !observable)
+        return;
+
+    Unbind(element, attribute);
+
+    UIBinding binding;
+    binding.element_ = element;
+    binding.attribute_ = attribute;
+    binding.observable_ = observable;
+    // Force the first application
+    binding.appliedVersion_ = observable->GetVersion() - 1;
+    bindings_.Push(binding);
+}
+
+void UIBinder::Unbind(UIElement* element, const String& attribute)
+{
+    for (unsigned i = 0; i < bindings_.Size(); ++i)
+    {
+        if (bindings_[i].element_.Get() == element && bindings_[i].attribute_ == attribute)
+        {
+            bindings_.Erase(i);
+            return;
+        }
+    }
+}
+
+void UIBinder::UnbindAll(UIElement* element)
+{
+    for (unsigned i = 0; i < bindings_.Size();)
+    {
+        if (bindings_[i].element_.Get() == element)
+            bindings_.Erase(i);
+        else
+            ++i;
+    }
+}
+
+void UIBinder::Apply()
+{
+    if (bindings_.Empty())
+        return;
+
+    PROFILE(ApplyUIBindings);
+
+    for (unsigned i = 0; i < bindings_.Size();)
+    {
+        UIBinding& binding = bindings_[i];
+        UIElement* element = binding.element_;
+        if (!element)
+        {
+            bindings_.Erase(i);
+            continue;
+        }
+
+        // Unchanged values are skipped before any attribute or layout work
+        unsigned version = binding.observable_->GetVersion();
+        if (version != binding.appliedVersion_)
+        {
+            binding.appliedVersion_ = version;
+            // Copy the binding, as setting the attribute may send events that change the bindings
+            String attribute = binding.attribute_;
+            SharedPtr<UIObservable> observable = binding.observable_;
+            bulkLayout_.Disable(element);
+            if (!element->SetAttribute(attribute, observable->GetValue()))
+                LOGWARNING("Could not apply bound value to attribute " + attribute + " of element " + element->GetName());
+        }
+
+        ++i;
+    }
+
+    bulkLayout_.Restore();
+}
+
+}
@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Ptr.h"
+#include "UICommandBuffer.h"
+#include "Variant.h"
+
+namespace Urho3D
+{
+
+class UIElement;
+
+/// Observable value for %UI data binding.
+class URHO3D_API UIObservable : public RefCounted
+{
+public:
+    /// Construct.
+    UIObservable() :
+        version_(0)
+    {
+    }
+
+    /// Set value. Setting the current value again does nothing, so bound elements are not updated.
+    void SetValue(const Variant& value)
+    {
+        if (value == value_)
+            return;
+        value_ = value;
+        ++version_;
+    }
+
+    /// Return value.
+    const Variant& GetValue() const { return value_; }
+    /// Return version, incremented on each change of value.
+    unsigned GetVersion() const { return version_; }
+
+private:
+    /// Value.
+    Variant value_;
+    /// Version.
+    unsigned version_;
+};
+
+/// Binding of an element attribute to an observable value.
+struct UIBinding
+{
+    /// Element.
+    WeakPtr<UIElement> element_;
+    /// Attribute name.
+    String attribute_;
+    /// Observable value.
+    SharedPtr<UIObservable> observable_;
+    /// Version of the value last applied.
+    unsigned appliedVersion_;
+};
+
+/// Element attributes bound to observable values. Parent layouts update once per application instead of once per changed value.
+class URHO3D_API UIBinder : public RefCounted
+{
+public:
+    /// Construct.
+    UIBinder();
+    /// Destruct.
+    virtual ~UIBinder();
+
+    /// Bind an element attribute to an observable value, replacing an existing binding of the attribute.
+    void Bind(UIElement* element, const String& attribute, UIObservable* observable);
+    /// Remove the binding of an element attribute.
+    void Unbind(UIElement* element, const String& attribute);
+    /// Remove all bindings of an element.
+    void UnbindAll(UIElement* element);
+    /// Set the attributes whose values have changed since the last application. Bindings of destroyed elements are removed.
+    void Apply();
+
+    /// Return number of bindings.
+    unsigned GetNumBindings() const { return bindings_.Size(); }
+
+private:
+    /// Bindings.
+    Vector<UIBinding> bindings_;
+    /// Parent layouts of the application in progress.
+    UIBulkLayout bulkLayout_;
+};
+
+}
@@ -0,0 +1,209 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "LineEdit.h"
+#include "Log.h"
+#include "Profiler.h"
+#include "Text.h"
+#include "UICommandBuffer.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Set text of a Text or LineEdit element.
+static void SetElementText(UIElement* element, const String& text)
+{
+    if (element->GetType() == LineEdit::GetTypeStatic())
+        static_cast<LineEdit*>(element)->SetText(text);
+    else
+    {
+        Text* textElement = dynamic_cast<Text*>(element);
+        if (textElement)
+            textElement->SetText(text);
+    }
+}
+
+void UIBulkLayout::Disable(UIElement* element)
+{
+    UIElement* parent = element->GetParent();
+    if (!parent)
+        return;
+
+    // Linear search: bulk updates typically touch a handful of parents
+    for (unsigned i = 0; i < parents_.Size(); ++i)
+    {
+        if (parents_[i].Get() == parent)
+            return;
+    }
+
+    parent->DisableLayoutUpdate();
+    parents_.Push(WeakPtr<UIElement>(parent));
+}
+
+void UIBulkLayout::Restore()
+{
+    for (unsigned i = 0; i < parents_.Size(); ++i)
+    {
+        UIElement* parent = parents_[i];
+        if (parent)
+        {
+            parent->EnableLayoutUpdate();
+            parent->UpdateLayout();
+        }
+    }
+
+    parents_.Clear();
+}
+
+UICommandBuffer::UICommandBuffer()
+{
+}
+
+UICommandBuffer::~UICommandBuffer()
+{
+}
+
+void UICommandBuffer::SetTexts(const PODVector<UIElement*>& elements, const Vector<String>& texts)
+{
+    if (elements.Size() != texts.Size())
+    {
+        LOGERROR("Element and text counts do not match");
+        return;
+    }
+
+    for (unsigned i = 0; i < elements.Size(); ++i)
+    {
+        if (!elements[i])
+            continue;
+        bulkLayout_.Disable(elements[i]);
+        SetElementText(elements[i], texts[i]);
+    }
+
+    bulkLayout_.Restore();
+}
+
+void UICommandBuffer::SetPositions(const PODVector<UIElement*>& elements, const PODVector<IntVector2>& positions)
+{
+    if (elements.Size() != positions.Size())
+    {
+        LOGERROR("Element and position counts do not match");
+        return;
+    }
+
+    for (unsigned i = 0; i < elements.Size(); ++i)
+    {
+        if (!elements[i])
+            continue;
+        bulkLayout_.Disable(elements[i]);
+        elements[i]->SetPosition(positions[i]);
+    }
+
+    bulkLayout_.Restore();
+}
+
+void UICommandBuffer::QueueSetText(UIElement* element, const String& text)
+{
+    Queue(element, UICMD_TEXT, text);
+}
+
+void UICommandBuffer::QueueSetPosition(UIElement* element, const IntVector2& position)
+{
+    Queue(element, UICMD_POSITION, position);
+}
+
+void UICommandBuffer::QueueSetColor(UIElement* element, const Color& color)
+{
+    Queue(element, UICMD_COLOR, color);
+}
+
+void UICommandBuffer::QueueSetVisible(UIElement* element, bool visible)
+{
+    Queue(element, UICMD_VISIBLE, visible);
+}
+
+void UICommandBuffer::QueueSetOpacity(UIElement* element, float opacity)
+{
+    Queue(element, UICMD_OPACITY, opacity);
+}
+
+void UICommandBuffer::Apply()
+{
+    if (commands_.Empty())
+        return;
+
+    PROFILE(ApplyUICommands);
+
+    // Commands may be queued by event handlers while applying, so copy each command before use
+    for (unsigned i = 0; i < commands_.Size(); ++i)
+    {
+        UICommand command = commands_[i];
+        UIElement* element = command.element_;
+        // The element may have been destroyed after queuing the command
+        if (!element)
+            continue;
+
+        bulkLayout_.Disable(element);
+
+        switch (command.type_)
+        {
+        case UICMD_TEXT:
+            SetElementText(element, command.value_.GetString());
+            break;
+
+        case UICMD_POSITION:
+            element->SetPosition(command.value_.GetIntVector2());
+            break;
+
+        case UICMD_COLOR:
+            element->SetColor(command.value_.GetColor());
+            break;
+
+        case UICMD_VISIBLE:
+            element->SetVisible(command.value_.GetBool());
+            break;
+
+        case UICMD_OPACITY:
+            element->SetOpacity(command.value_.GetFloat());
+            break;
+        }
+    }
+
+    commands_.Clear();
+    bulkLayout_.Restore();
+}
+
+void UICommandBuffer::Queue(UIElement* element, UICommandType type, const Variant& value)
+{
+    if (!element)
+        return;
+
+    UICommand command;
+    command.element_ = element;
+    command.type_ = type;
+    command.value_ = value;
+    commands_.Push(command);
+}
+
+}
@@ -0,0 +1,107 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Ptr.h"
+#include "Variant.h"
+
+namespace Urho3D
+{
+
+class UIElement;
+
+/// Deferred %UI element property change.
+enum UICommandType
+{
+    UICMD_TEXT = 0,
+    UICMD_POSITION,
+    UICMD_COLOR,
+    UICMD_VISIBLE,
+    UICMD_OPACITY
+};
+
+/// Deferred %UI command.
+struct UICommand
+{
+    /// Target element.
+    WeakPtr<UIElement> element_;
+    /// Property to change.
+    UICommandType type_;
+    /// New value.
+    Variant value_;
+};
+
+/// Layout updates of the parents of changed elements, disabled during a bulk update and done once at the end.
+class URHO3D_API UIBulkLayout
+{
+public:
+    /// Disable layout updates of an element's parent until Restore() is called.
+    void Disable(UIElement* element);
+    /// Re-enable and update the disabled layouts.
+    void Restore();
+
+private:
+    /// Parents with layout updates disabled.
+    Vector<WeakPtr<UIElement> > parents_;
+};
+
+/// Bulk and deferred %UI element property changes. Parent layouts update once per bulk update or command buffer application instead of once per change.
+class URHO3D_API UICommandBuffer : public RefCounted
+{
+public:
+    /// Construct.
+    UICommandBuffer();
+    /// Destruct.
+    virtual ~UICommandBuffer();
+
+    /// Set text of many Text or LineEdit elements at once.
+    void SetTexts(const PODVector<UIElement*>& elements, const Vector<String>& texts);
+    /// Set position of many elements at once.
+    void SetPositions(const PODVector<UIElement*>& elements, const PODVector<IntVector2>& positions);
+    /// Queue a text change of a Text or LineEdit element.
+    void QueueSetText(UIElement* element, const String& text);
+    /// Queue a position change.
+    void QueueSetPosition(UIElement* element, const IntVector2& position);
+    /// Queue a color change.
+    void QueueSetColor(UIElement* element, const Color& color);
+    /// Queue a visibility change.
+    void QueueSetVisible(UIElement* element, bool visible);
+    /// Queue an opacity change.
+    void QueueSetOpacity(UIElement* element, float opacity);
+    /// Apply the queued commands. Commands of destroyed elements are skipped.
+    void Apply();
+
+    /// Return number of queued commands.
+    unsigned GetNumCommands() const { return commands_.Size(); }
+
+private:
+    /// Queue a command.
+    void Queue(UIElement* element, UICommandType type, const Variant& value);
+
+    /// Queued commands.
+    Vector<UICommand> commands_;
+    /// Parent layouts of the bulk update in progress.
+    UIBulkLayout bulkLayout_;
+};
+
+}
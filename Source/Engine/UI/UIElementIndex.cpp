@@ -0,0 +1,171 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "UIElement.h"
+#include "UIElementIndex.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+UIElementIndex::UIElementIndex(UIElement* root, UIElement* modalRoot) :
+    root_(root),
+    modalRoot_(modalRoot)
+{
+}
+
+UIElementIndex::~UIElementIndex()
+{
+}
+
+UIElement* UIElementIndex::FindElement(const String& name)
+{
+    if (name.Empty())
+        return 0;
+
+    StringHash nameHash(name);
+
+    // Use the indexed element if it still has the name and has not been removed from the hierarchy
+    HashMap<StringHash, WeakPtr<UIElement> >::Iterator i = nameIndex_.Find(nameHash);
+    if (i != nameIndex_.End())
+    {
+        UIElement* element = i->second_;
+        if (element && element->GetName() == name && IsInHierarchy(element))
+            return element;
+        nameIndex_.Erase(i);
+    }
+
+    UIElement* element = root_->GetChild(name, true);
+    if (!element)
+        element = modalRoot_->GetChild(name, true);
+    if (element)
+        nameIndex_[nameHash] = element;
+
+    return element;
+}
+
+void UIElementIndex::AddTag(UIElement* element, const String& tag)
+{
+    if (!element || tag.Empty())
+        return;
+
+    if (!HasTag(element, tag))
+        tagIndex_[StringHash(tag)].Push(WeakPtr<UIElement>(element));
+}
+
+void UIElementIndex::RemoveTag(UIElement* element, const String& tag)
+{
+    HashMap<StringHash, Vector<WeakPtr<UIElement> > >::Iterator i = tagIndex_.Find(StringHash(tag));
+    if (i == tagIndex_.End())
+        return;
+
+    Vector<WeakPtr<UIElement> >& elements = i->second_;
+    for (unsigned j = 0; j < elements.Size(); ++j)
+    {
+        if (elements[j].Get() == element)
+        {
+            elements.Erase(j);
+            break;
+        }
+    }
+
+    if (elements.Empty())
+        tagIndex_.Erase(i);
+}
+
+void UIElementIndex::RemoveAllTags(UIElement* element)
+{
+    for (HashMap<StringHash, Vector<WeakPtr<UIElement> > >::Iterator i = tagIndex_.Begin(); i != tagIndex_.End();)
+    {
+        Vector<WeakPtr<UIElement> >& elements = i->second_;
+        for (unsigned j = 0; j < elements.Size(); ++j)
+        {
+            if (elements[j].Get() == element)
+            {
+                elements.Erase(j);
+                break;
+            }
+        }
+
+        if (elements.Empty())
+            i = tagIndex_.Erase(i);
+        else
+            ++i;
+    }
+}
+
+bool UIElementIndex::HasTag(UIElement* element, const String& tag) const
+{
+    HashMap<StringHash, Vector<WeakPtr<UIElement> > >::ConstIterator i = tagIndex_.Find(StringHash(tag));
+    if (i == tagIndex_.End())
+        return false;
+
+    const Vector<WeakPtr<UIElement> >& elements = i->second_;
+    for (unsigned j = 0; j < elements.Size(); ++j)
+    {
+        if (elements[j].Get() == element)
+            return true;
+    }
+
+    return false;
+}
+
+PODVector<UIElement*> UIElementIndex::GetElementsWithTag(const String& tag)
+{
+    PODVector<UIElement*> result;
+
+    HashMap<StringHash, Vector<WeakPtr<UIElement> > >::Iterator i = tagIndex_.Find(StringHash(tag));
+    if (i == tagIndex_.End())
+        return result;
+
+    // Prune destroyed elements while collecting
+    Vector<WeakPtr<UIElement> >& elements = i->second_;
+    for (unsigned j = 0; j < elements.Size();)
+    {
+        if (elements[j])
+            result.Push(elements[j++]);
+        else
+            elements.Erase(j);
+    }
+
+    if (elements.Empty())
+        tagIndex_.Erase(i);
+
+    return result;
+}
+
+bool UIElementIndex::IsInHierarchy(UIElement* element) const
+{
+    UIElement* parent = element->GetParent();
+    while (parent)
+    {
+        if (parent == root_ || parent == modalRoot_)
+            return true;
+        parent = parent->GetParent();
+    }
+
+    return false;
+}
+
+}
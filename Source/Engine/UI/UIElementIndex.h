@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "HashMap.h"
+#include "Ptr.h"
+#include "StringHash.h"
+
+namespace Urho3D
+{
+
+class UIElement;
+
+/// Index of %UI elements by name and by tag. Names are indexed on first lookup and validated on later ones, since elements can be renamed or reparented.
+class URHO3D_API UIElementIndex : public RefCounted
+{
+public:
+    /// Construct with the root elements to search.
+    UIElementIndex(UIElement* root, UIElement* modalRoot);
+    /// Destruct.
+    virtual ~UIElementIndex();
+
+    /// Return element by name from the root and modal root hierarchies.
+    UIElement* FindElement(const String& name);
+    /// Add a tag to an element.
+    void AddTag(UIElement* element, const String& tag);
+    /// Remove a tag from an element.
+    void RemoveTag(UIElement* element, const String& tag);
+    /// Remove all tags from an element.
+    void RemoveAllTags(UIElement* element);
+
+    /// Return whether an element has a tag.
+    bool HasTag(UIElement* element, const String& tag) const;
+    /// Return elements with a tag. Destroyed elements are pruned.
+    PODVector<UIElement*> GetElementsWithTag(const String& tag);
+
+private:
+    /// Return whether an element is still parented to the root or modal root element.
+    bool IsInHierarchy(UIElement* element) const;
+
+    /// Root element.
+    WeakPtr<UIElement> root_;
+    /// Modal root element.
+    WeakPtr<UIElement> modalRoot_;
+    /// Elements indexed by name.
+    HashMap<StringHash, WeakPtr<UIElement> > nameIndex_;
+    /// Elements indexed by tag.
+    HashMap<StringHash, Vector<WeakPtr<UIElement> > > tagIndex_;
+};
+
+}
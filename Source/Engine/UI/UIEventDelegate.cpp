@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "MathDefs.h"
+#include "UIElement.h"
+#include "UIEventDelegate.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+const unsigned MIN_DELEGATE_SWEEP_SIZE = 16;
+
+void UIDelegateMap::Set(UIElement* element, UIEventDelegate* delegate)
+{
+    if (!element)
+        return;
+
+    if (!delegate)
+    {
+        delegates_.Erase(element);
+        return;
+    }
+
+    // Destroyed elements that are not clicked again would keep their delegates forever, so sweep the expired ones whenever the
+    // map grows to a power of two. This keeps the cost amortized constant per new delegate
+    unsigned size = delegates_.Size();
+    if (size >= MIN_DELEGATE_SWEEP_SIZE && IsPowerOfTwo(size) && !delegates_.Contains(element))
+        Prune();
+
+    UIDelegateBinding& binding = delegates_[element];
+    binding.element_ = element;
+    binding.delegate_ = delegate;
+}
+
+void UIDelegateMap::Invoke(UIElement* element, const IntVector2& pos)
+{
+    if (!element || delegates_.Empty())
+        return;
+
+    HashMap<UIElement*, UIDelegateBinding>::Iterator i = delegates_.Find(element);
+    if (i == delegates_.End())
+        return;
+
+    // The element may have been destroyed and another created at the same address
+    if (i->second_.element_.Expired())
+    {
+        delegates_.Erase(i);
+        return;
+    }
+
+    // Hold a reference, as the delegate may replace itself
+    SharedPtr<UIEventDelegate> delegate(i->second_.delegate_);
+    delegate->Invoke(element, pos.x_, pos.y_);
+}
+
+UIEventDelegate* UIDelegateMap::Get(UIElement* element) const
+{
+    HashMap<UIElement*, UIDelegateBinding>::ConstIterator i = delegates_.Find(element);
+    if (i == delegates_.End() || i->second_.element_.Expired())
+        return 0;
+    return i->second_.delegate_;
+}
+
+void UIDelegateMap::Prune()
+{
+    for (HashMap<UIElement*, UIDelegateBinding>::Iterator i = delegates_.Begin(); i != delegates_.End();)
+    {
+        if (i->second_.element_.Expired())
+            i = delegates_.Erase(i);
+        else
+            ++i;
+    }
+}
+
+}
@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "HashMap.h"
+#include "Ptr.h"
+#include "Vector2.h"
+
+namespace Urho3D
+{
+
+class UIElement;
+
+/// Typed callback invoked directly by the %UI subsystem, without building an event parameter map.
+class URHO3D_API UIEventDelegate : public RefCounted
+{
+public:
+    /// Invoke with the element and the screen position of the event.
+    virtual void Invoke(UIElement* element, int x, int y) = 0;
+};
+
+/// Delegate attached to a %UI element.
+struct UIDelegateBinding
+{
+    /// Element. Used to detect a destroyed element whose address has been reused.
+    WeakPtr<UIElement> element_;
+    /// Delegate.
+    SharedPtr<UIEventDelegate> delegate_;
+};
+
+/// Delegates of one %UI event by element.
+class URHO3D_API UIDelegateMap
+{
+public:
+    /// Set delegate of an element. Null removes.
+    void Set(UIElement* element, UIEventDelegate* delegate);
+    /// Invoke the delegate of an element if it has one.
+    void Invoke(UIElement* element, const IntVector2& pos);
+
+    /// Return delegate of an element, or null if none.
+    UIEventDelegate* Get(UIElement* element) const;
+
+private:
+    /// Erase the delegates of destroyed elements.
+    void Prune();
+
+    /// Delegates. Those of destroyed elements are swept as the map grows.
+    HashMap<UIElement*, UIDelegateBinding> delegates_;
+};
+
+}
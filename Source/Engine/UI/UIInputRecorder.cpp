@@ -0,0 +1,169 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "File.h"
+#include "Log.h"
+#include "Timer.h"
+#include "UIInputRecorder.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+static const String INPUT_RECORDING_ID("UIN2");
+
+UIInputRecorder::UIInputRecorder(Context* context) :
+    Object(context),
+    startTime_(0),
+    frame_(0),
+    replayPosition_(0),
+    replaying_(false),
+    replayMousePosition_(IntVector2::ZERO),
+    replayMouseVisible_(false),
+    replayTime_(0)
+{
+}
+
+UIInputRecorder::~UIInputRecorder()
+{
+}
+
+bool UIInputRecorder::BeginRecording(const String& fileName, const UIInputRecordingState& state)
+{
+    EndRecording();
+
+    SharedPtr<File> file(new File(context_, fileName, FILE_WRITE));
+    if (!file->IsOpen())
+        return false;
+
+    file->WriteFileID(INPUT_RECORDING_ID);
+    file->WriteIntVector2(state.rootSize_);
+    file->WriteIntVector2(state.mousePosition_);
+    file->WriteBool(state.mouseVisible_);
+    file->WriteBool(state.hasCursor_);
+    if (state.hasCursor_)
+    {
+        file->WriteIntVector2(state.cursorPosition_);
+        file->WriteBool(state.cursorVisible_);
+    }
+
+    file_ = file;
+    startTime_ = Time::GetSystemTime();
+    frame_ = 0;
+
+    LOGINFO("Began UI input recording to " + fileName);
+    return true;
+}
+
+void UIInputRecorder::EndRecording()
+{
+    if (!file_)
+        return;
+
+    LOGINFO("Ended UI input recording to " + file_->GetName());
+    file_.Reset();
+}
+
+void UIInputRecorder::Record(StringHash eventType, const VariantMap& eventData, const IntVector2& mousePosition, bool mouseVisible)
+{
+    if (!file_)
+        return;
+
+    file_->WriteStringHash(eventType);
+    file_->WriteUInt(frame_);
+    file_->WriteUInt(Time::GetSystemTime() - startTime_);
+    file_->WriteIntVector2(mousePosition);
+    file_->WriteBool(mouseVisible);
+    file_->WriteVariantMap(eventData);
+}
+
+bool UIInputRecorder::BeginReplay(const String& fileName, UIInputRecordingState& state)
+{
+    EndReplay();
+
+    SharedPtr<File> file(new File(context_, fileName, FILE_READ));
+    if (!file->IsOpen())
+        return false;
+
+    if (file->ReadFileID() != INPUT_RECORDING_ID)
+    {
+        LOGERROR(fileName + " is not a valid UI input recording");
+        return false;
+    }
+
+    state.rootSize_ = file->ReadIntVector2();
+    state.mousePosition_ = file->ReadIntVector2();
+    state.mouseVisible_ = file->ReadBool();
+    state.hasCursor_ = file->ReadBool();
+    state.cursorPosition_ = state.hasCursor_ ? file->ReadIntVector2() : IntVector2::ZERO;
+    state.cursorVisible_ = state.hasCursor_ ? file->ReadBool() : false;
+
+    replayEvents_.Clear();
+    while (!file->IsEof())
+    {
+        RecordedUIInput input;
+        input.eventType_ = file->ReadStringHash();
+        input.frame_ = file->ReadUInt();
+        input.time_ = file->ReadUInt();
+        input.mousePosition_ = file->ReadIntVector2();
+        input.mouseVisible_ = file->ReadBool();
+        input.eventData_ = file->ReadVariantMap();
+        replayEvents_.Push(input);
+    }
+
+    replayMousePosition_ = state.mousePosition_;
+    replayMouseVisible_ = state.mouseVisible_;
+    replayPosition_ = 0;
+    replayTime_ = 0;
+    frame_ = 0;
+    replaying_ = true;
+
+    LOGINFO("Began UI input replay of " + String(replayEvents_.Size()) + " events from " + fileName);
+    return true;
+}
+
+void UIInputRecorder::EndReplay()
+{
+    if (!replaying_)
+        return;
+
+    replaying_ = false;
+    replayEvents_.Clear();
+
+    LOGINFO("Ended UI input replay after " + String(frame_) + " frames");
+}
+
+bool UIInputRecorder::GetNextReplayEvent(RecordedUIInput& input)
+{
+    if (!replaying_ || replayPosition_ >= replayEvents_.Size() || replayEvents_[replayPosition_].frame_ > frame_)
+        return false;
+
+    input = replayEvents_[replayPosition_++];
+    replayMousePosition_ = input.mousePosition_;
+    replayMouseVisible_ = input.mouseVisible_;
+    replayTime_ = input.time_;
+    return true;
+}
+
+}
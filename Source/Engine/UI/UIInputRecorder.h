@@ -0,0 +1,138 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Object.h"
+#include "Vector2.h"
+
+namespace Urho3D
+{
+
+class File;
+
+/// Input event recorded by the %UI subsystem.
+struct RecordedUIInput
+{
+    /// Event type.
+    StringHash eventType_;
+    /// Frame number counted from the start of the recording.
+    unsigned frame_;
+    /// Time in milliseconds from the start of the recording.
+    unsigned time_;
+    /// Operating system mouse position when the event was received.
+    IntVector2 mousePosition_;
+    /// Operating system mouse visibility when the event was received.
+    bool mouseVisible_;
+    /// Event parameters.
+    VariantMap eventData_;
+};
+
+/// %UI state at the start of an input recording, which the recorded events depend on.
+struct UIInputRecordingState
+{
+    /// Construct with defaults.
+    UIInputRecordingState() :
+        rootSize_(IntVector2::ZERO),
+        mousePosition_(IntVector2::ZERO),
+        mouseVisible_(false),
+        hasCursor_(false),
+        cursorPosition_(IntVector2::ZERO),
+        cursorVisible_(false)
+    {
+    }
+
+    /// Root element size.
+    IntVector2 rootSize_;
+    /// Operating system mouse position.
+    IntVector2 mousePosition_;
+    /// Operating system mouse visibility.
+    bool mouseVisible_;
+    /// Whether a %UI cursor exists.
+    bool hasCursor_;
+    /// %UI cursor position.
+    IntVector2 cursorPosition_;
+    /// %UI cursor visibility.
+    bool cursorVisible_;
+};
+
+/// Recording of %UI input events to a file and their replay frame by frame.
+class URHO3D_API UIInputRecorder : public Object
+{
+    OBJECT(UIInputRecorder);
+
+public:
+    /// Construct.
+    UIInputRecorder(Context* context);
+    /// Destruct.
+    virtual ~UIInputRecorder();
+
+    /// Begin recording to a file, starting from the given state. Return true if successful.
+    bool BeginRecording(const String& fileName, const UIInputRecordingState& state);
+    /// End recording.
+    void EndRecording();
+    /// Record an input event along with the operating system mouse state.
+    void Record(StringHash eventType, const VariantMap& eventData, const IntVector2& mousePosition, bool mouseVisible);
+    /// Begin replaying the events of a file and return the state the recording started from. Return true if successful.
+    bool BeginReplay(const String& fileName, UIInputRecordingState& state);
+    /// End replay.
+    void EndReplay();
+    /// Return the next event to replay on the current frame and make its mouse state and time current. Return false when none remain for the frame.
+    bool GetNextReplayEvent(RecordedUIInput& input);
+    /// Advance the frame counter of the recording or replay.
+    void NextFrame() { ++frame_; }
+
+    /// Return whether recording.
+    bool IsRecording() const { return file_.NotNull(); }
+    /// Return whether replaying.
+    bool IsReplaying() const { return replaying_; }
+    /// Return whether all events of the replay have been returned.
+    bool IsReplayFinished() const { return replayPosition_ >= replayEvents_.Size(); }
+    /// Return operating system mouse position of the event being replayed.
+    const IntVector2& GetReplayMousePosition() const { return replayMousePosition_; }
+    /// Return operating system mouse visibility of the event being replayed.
+    bool IsReplayMouseVisible() const { return replayMouseVisible_; }
+    /// Return time in milliseconds of the event being replayed.
+    unsigned GetReplayTime() const { return replayTime_; }
+
+private:
+    /// Recording file.
+    SharedPtr<File> file_;
+    /// System time in milliseconds when the recording began.
+    unsigned startTime_;
+    /// Frame number of the recording or replay.
+    unsigned frame_;
+    /// Recorded events being replayed.
+    Vector<RecordedUIInput> replayEvents_;
+    /// Index of the next event to replay.
+    unsigned replayPosition_;
+    /// Replay flag.
+    bool replaying_;
+    /// Operating system mouse position of the event being replayed.
+    IntVector2 replayMousePosition_;
+    /// Operating system mouse visibility of the event being replayed.
+    bool replayMouseVisible_;
+    /// Time in milliseconds of the event being replayed.
+    unsigned replayTime_;
+};
+
+}
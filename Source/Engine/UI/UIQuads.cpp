@@ -0,0 +1,213 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "UIQuads.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QUADS_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define QUADS_NEON
+#endif
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+void WriteQuads(float* dest, const float* rects, const float* uvRects, unsigned count, unsigned color, const Vector2& offset)
+{
+    #if defined(QUADS_SSE2)
+    // Vertex layout is x, y, z, color, u, v. One quad is 36 floats, which is written as nine 4-float chunks
+    const __m128 zeroColor = _mm_castsi128_ps(_mm_set_epi32((int)color, 0, (int)color, 0));
+    const __m128 posOffset = _mm_set_ps(offset.y_, offset.x_, offset.y_, offset.x_);
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        __m128 p = _mm_add_ps(_mm_loadu_ps(rects), posOffset);
+        __m128 t = _mm_loadu_ps(uvRects);
+        __m128 zcTex = _mm_shuffle_ps(zeroColor, t, _MM_SHUFFLE(1, 2, 1, 0));
+        __m128 texPos = _mm_shuffle_ps(t, p, _MM_SHUFFLE(1, 2, 3, 0));
+
+        _mm_storeu_ps(dest, _mm_shuffle_ps(p, zeroColor, _MM_SHUFFLE(1, 0, 1, 0)));
+        _mm_storeu_ps(dest + 4, _mm_shuffle_ps(t, p, _MM_SHUFFLE(1, 2, 1, 0)));
+        _mm_storeu_ps(dest + 8, zcTex);
+        _mm_storeu_ps(dest + 12, _mm_shuffle_ps(p, zeroColor, _MM_SHUFFLE(1, 0, 3, 0)));
+        _mm_storeu_ps(dest + 16, texPos);
+        _mm_storeu_ps(dest + 20, zcTex);
+        _mm_storeu_ps(dest + 24, _mm_shuffle_ps(p, zeroColor, _MM_SHUFFLE(1, 0, 3, 2)));
+        _mm_storeu_ps(dest + 28, _mm_shuffle_ps(t, p, _MM_SHUFFLE(3, 0, 3, 2)));
+        _mm_storeu_ps(dest + 32, _mm_shuffle_ps(zeroColor, t, _MM_SHUFFLE(3, 0, 1, 0)));
+
+        rects += 4;
+        uvRects += 4;
+        dest += 6 * UI_VERTEX_SIZE;
+    }
+    #elif defined(QUADS_NEON)
+    float zc[2];
+    zc[0] = 0.0f;
+    ((unsigned&)zc[1]) = color;
+    const float32x2_t zeroColor = vld1_f32(zc);
+    const float32x2_t posOffset = vset_lane_f32(offset.y_, vdup_n_f32(offset.x_), 1);
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        float32x4_t p = vld1q_f32(rects);
+        float32x4_t t = vld1q_f32(uvRects);
+        float32x2_t leftTop = vadd_f32(vget_low_f32(p), posOffset);
+        float32x2_t rightBottom = vadd_f32(vget_high_f32(p), posOffset);
+        float32x2_t uvLeftTop = vget_low_f32(t);
+        float32x2_t uvRightBottom = vget_high_f32(t);
+        float32x2_t rightTop = vset_lane_f32(vget_lane_f32(leftTop, 1), rightBottom, 1);
+        float32x2_t leftBottom = vset_lane_f32(vget_lane_f32(leftTop, 0), rightBottom, 0);
+        float32x2_t uvRightTop = vset_lane_f32(vget_lane_f32(uvLeftTop, 1), uvRightBottom, 1);
+        float32x2_t uvLeftBottom = vset_lane_f32(vget_lane_f32(uvLeftTop, 0), uvRightBottom, 0);
+
+        vst1q_f32(dest, vcombine_f32(leftTop, zeroColor));
+        vst1q_f32(dest + 4, vcombine_f32(uvLeftTop, rightTop));
+        vst1q_f32(dest + 8, vcombine_f32(zeroColor, uvRightTop));
+        vst1q_f32(dest + 12, vcombine_f32(leftBottom, zeroColor));
+        vst1q_f32(dest + 16, vcombine_f32(uvLeftBottom, rightTop));
+        vst1q_f32(dest + 20, vcombine_f32(zeroColor, uvRightTop));
+        vst1q_f32(dest + 24, vcombine_f32(rightBottom, zeroColor));
+        vst1q_f32(dest + 28, vcombine_f32(uvRightBottom, leftBottom));
+        vst1q_f32(dest + 32, vcombine_f32(zeroColor, uvLeftBottom));
+
+        rects += 4;
+        uvRects += 4;
+        dest += 6 * UI_VERTEX_SIZE;
+    }
+    #else
+    WriteQuadsScalar(dest, rects, uvRects, count, color, offset);
+    #endif
+}
+
+void WriteQuadsScalar(float* dest, const float* rects, const float* uvRects, unsigned count, unsigned color, const Vector2& offset)
+{
+    for (unsigned i = 0; i < count; ++i)
+    {
+        float left = rects[0] + offset.x_;
+        float top = rects[1] + offset.y_;
+        float right = rects[2] + offset.x_;
+        float bottom = rects[3] + offset.y_;
+        float leftUV = uvRects[0];
+        float topUV = uvRects[1];
+        float rightUV = uvRects[2];
+        float bottomUV = uvRects[3];
+
+        dest[0] = left; dest[1] = top; dest[2] = 0.0f;
+        ((unsigned&)dest[3]) = color;
+        dest[4] = leftUV; dest[5] = topUV;
+
+        dest[6] = right; dest[7] = top; dest[8] = 0.0f;
+        ((unsigned&)dest[9]) = color;
+        dest[10] = rightUV; dest[11] = topUV;
+
+        dest[12] = left; dest[13] = bottom; dest[14] = 0.0f;
+        ((unsigned&)dest[15]) = color;
+        dest[16] = leftUV; dest[17] = bottomUV;
+
+        dest[18] = right; dest[19] = top; dest[20] = 0.0f;
+        ((unsigned&)dest[21]) = color;
+        dest[22] = rightUV; dest[23] = topUV;
+
+        dest[24] = right; dest[25] = bottom; dest[26] = 0.0f;
+        ((unsigned&)dest[27]) = color;
+        dest[28] = rightUV; dest[29] = bottomUV;
+
+        dest[30] = left; dest[31] = bottom; dest[32] = 0.0f;
+        ((unsigned&)dest[33]) = color;
+        dest[34] = leftUV; dest[35] = bottomUV;
+
+        rects += 4;
+        uvRects += 4;
+        dest += 6 * UI_VERTEX_SIZE;
+    }
+}
+
+void TranslateVertices(float* dest, const float* src, unsigned numVertices, const Vector2& offset)
+{
+    #if defined(QUADS_SSE2)
+    const __m128 posOffset = _mm_set_ps(offset.y_, offset.x_, offset.y_, offset.x_);
+    unsigned i = 0;
+
+    // Two vertices are three 4-float chunks: x y z color, u v x y, z color u v. Only the x and y halves take the added values, so the color bits are copied unchanged
+    for (; i + 1 < numVertices; i += 2)
+    {
+        __m128 a = _mm_loadu_ps(src);
+        __m128 b = _mm_loadu_ps(src + 4);
+        __m128 c = _mm_loadu_ps(src + 8);
+        __m128 movedA = _mm_add_ps(a, posOffset);
+        __m128 movedB = _mm_add_ps(b, posOffset);
+        _mm_storeu_ps(dest, _mm_castpd_ps(_mm_move_sd(_mm_castps_pd(a), _mm_castps_pd(movedA))));
+        _mm_storeu_ps(dest + 4, _mm_castpd_ps(_mm_move_sd(_mm_castps_pd(movedB), _mm_castps_pd(b))));
+        _mm_storeu_ps(dest + 8, c);
+
+        src += 2 * UI_VERTEX_SIZE;
+        dest += 2 * UI_VERTEX_SIZE;
+    }
+
+    if (i < numVertices)
+        TranslateVerticesScalar(dest, src, 1, offset);
+    #elif defined(QUADS_NEON)
+    const float32x2_t posOffset = vset_lane_f32(offset.y_, vdup_n_f32(offset.x_), 1);
+
+    for (unsigned i = 0; i < numVertices; ++i)
+    {
+        float32x2_t pos = vld1_f32(src);
+        float32x4_t rest = vld1q_f32(src + 2);
+        vst1_f32(dest, vadd_f32(pos, posOffset));
+        vst1q_f32(dest + 2, rest);
+
+        src += UI_VERTEX_SIZE;
+        dest += UI_VERTEX_SIZE;
+    }
+    #else
+    TranslateVerticesScalar(dest, src, numVertices, offset);
+    #endif
+}
+
+void TranslateVerticesScalar(float* dest, const float* src, unsigned numVertices, const Vector2& offset)
+{
+    for (unsigned i = 0; i < numVertices; ++i)
+    {
+        float x = src[0] + offset.x_;
+        float y = src[1] + offset.y_;
+        float z = src[2];
+        float color = src[3];
+        float u = src[4];
+        float v = src[5];
+        dest[0] = x;
+        dest[1] = y;
+        dest[2] = z;
+        dest[3] = color;
+        dest[4] = u;
+        dest[5] = v;
+
+        src += UI_VERTEX_SIZE;
+        dest += UI_VERTEX_SIZE;
+    }
+}
+
+}
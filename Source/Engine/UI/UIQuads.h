@@ -0,0 +1,39 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "UIBatch.h"
+
+namespace Urho3D
+{
+
+/// Write textured quads as interleaved UI vertices, six vertices per quad in the same order as UIBatch::AddQuad(). Positions and texture coordinates are given as left, top, right, bottom per quad, and the offset is added to the positions. The destination must have room for count * 6 * UI_VERTEX_SIZE floats.
+URHO3D_API void WriteQuads(float* dest, const float* rects, const float* uvRects, unsigned count, unsigned color, const Vector2& offset = Vector2::ZERO);
+/// Write textured quads using the scalar code path only. Used as a reference for the vectorized path.
+URHO3D_API void WriteQuadsScalar(float* dest, const float* rects, const float* uvRects, unsigned count, unsigned color, const Vector2& offset = Vector2::ZERO);
+/// Translate the positions of UI vertices and copy their colors and texture coordinates. Used to place cached local space glyph quads at the element's screen position. The destination may be the same as the source.
+URHO3D_API void TranslateVertices(float* dest, const float* src, unsigned numVertices, const Vector2& offset);
+/// Translate UI vertices using the scalar code path only.
+URHO3D_API void TranslateVerticesScalar(float* dest, const float* src, unsigned numVertices, const Vector2& offset);
+
+}
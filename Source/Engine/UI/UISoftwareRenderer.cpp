@@ -0,0 +1,519 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "Graphics.h"
+#include "Image.h"
+#include "Log.h"
+#include "Texture2D.h"
+#include "UISoftwareRenderer.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SOFTWARE_SSE2
+#endif
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Divide by 255 with rounding, exact for the products of two bytes.
+static inline unsigned Div255(unsigned x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+/// Fill a span of RGBA pixels with a color.
+static void FillSpanReplace(unsigned char* dest, unsigned count, unsigned color)
+{
+    unsigned i = 0;
+    #ifdef SOFTWARE_SSE2
+    const __m128i src = _mm_set1_epi32((int)color);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4), src);
+    #endif
+    for (; i < count; ++i)
+        memcpy(dest + i * 4, &color, sizeof color);
+}
+
+/// Alpha blend a color over a span of RGBA pixels. The vector and scalar paths give identical results.
+static void FillSpanAlpha(unsigned char* dest, unsigned count, unsigned color)
+{
+    unsigned char src[4];
+    memcpy(src, &color, sizeof color);
+    unsigned alpha = src[3];
+    unsigned invAlpha = 255 - alpha;
+
+    unsigned i = 0;
+    #ifdef SOFTWARE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i srcTerm = _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero), _mm_set1_epi16((short)alpha));
+    const __m128i invAlphaVec = _mm_set1_epi16((short)invAlpha);
+    const __m128i bias = _mm_set1_epi16(128);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dest + i * 4));
+        __m128i low = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero), invAlphaVec), srcTerm), bias);
+        __m128i high = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero), invAlphaVec), srcTerm), bias);
+        low = _mm_srli_epi16(_mm_add_epi16(low, _mm_srli_epi16(low, 8)), 8);
+        high = _mm_srli_epi16(_mm_add_epi16(high, _mm_srli_epi16(high, 8)), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4), _mm_packus_epi16(low, high));
+    }
+    #endif
+    for (; i < count; ++i)
+    {
+        unsigned char* pixel = dest + i * 4;
+        for (unsigned j = 0; j < 4; ++j)
+            pixel[j] = (unsigned char)Div255(src[j] * alpha + pixel[j] * invAlpha);
+    }
+}
+
+/// Blend a color with components in the 0-1 range into an RGBA pixel. Matches the graphics device blend states.
+static void BlendPixel(unsigned char* dest, const float* src, BlendMode blendMode)
+{
+    float d[4];
+    for (unsigned j = 0; j < 4; ++j)
+        d[j] = dest[j] * (1.0f / 255.0f);
+
+    float srcAlpha = src[3];
+    float destAlpha = d[3];
+
+    for (unsigned j = 0; j < 4; ++j)
+    {
+        float result;
+        switch (blendMode)
+        {
+        case BLEND_REPLACE:
+            result = src[j];
+            break;
+
+        case BLEND_ADD:
+            result = src[j] + d[j];
+            break;
+
+        case BLEND_MULTIPLY:
+            result = src[j] * d[j];
+            break;
+
+        case BLEND_ADDALPHA:
+            result = src[j] * srcAlpha + d[j];
+            break;
+
+        case BLEND_PREMULALPHA:
+            result = src[j] + d[j] * (1.0f - srcAlpha);
+            break;
+
+        case BLEND_INVDESTALPHA:
+            result = src[j] * (1.0f - destAlpha) + d[j] * destAlpha;
+            break;
+
+        case BLEND_SUBTRACT:
+            result = d[j] - src[j];
+            break;
+
+        case BLEND_SUBTRACTALPHA:
+            result = d[j] - src[j] * srcAlpha;
+            break;
+
+        default:
+            result = src[j] * srcAlpha + d[j] * (1.0f - srcAlpha);
+            break;
+        }
+
+        dest[j] = (unsigned char)(Clamp(result, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+}
+
+/// Return the edge function of a point against the edge from a to b. Positive on the inside of a triangle with positive area.
+static inline float EdgeFunction(const float* a, const float* b, float x, float y)
+{
+    return (b[0] - a[0]) * (y - a[1]) - (b[1] - a[1]) * (x - a[0]);
+}
+
+/// Return whether an edge is a top or left edge, which own the pixels exactly on them so that shared edges are drawn once.
+static inline bool IsTopLeftEdge(const float* a, const float* b)
+{
+    float dx = b[0] - a[0];
+    float dy = b[1] - a[1];
+    return dy < 0.0f || (dy == 0.0f && dx > 0.0f);
+}
+
+/// Return whether a quad in UIBatch::AddQuad() vertex order is an axis-aligned rectangle of one color.
+static bool IsSolidRect(const float* quad)
+{
+    const float* v[6];
+    for (unsigned i = 0; i < 6; ++i)
+        v[i] = quad + i * UI_VERTEX_SIZE;
+
+    if (v[0][0] != v[2][0] || v[0][0] != v[5][0] || v[1][0] != v[3][0] || v[1][0] != v[4][0])
+        return false;
+    if (v[0][1] != v[1][1] || v[0][1] != v[3][1] || v[2][1] != v[4][1] || v[2][1] != v[5][1])
+        return false;
+    if (v[1][0] <= v[0][0] || v[2][1] <= v[0][1])
+        return false;
+
+    for (unsigned i = 1; i < 6; ++i)
+    {
+        if (memcmp(&v[i][3], &v[0][3], sizeof(unsigned)))
+            return false;
+    }
+
+    return true;
+}
+
+UISoftwareRenderer::UISoftwareRenderer() :
+    pixels_(0),
+    width_(0),
+    numSkippedBatches_(0)
+{
+}
+
+UISoftwareRenderer::~UISoftwareRenderer()
+{
+}
+
+void UISoftwareRenderer::SetTextureImage(Texture* texture, Image* image)
+{
+    if (!texture)
+        return;
+
+    if (image)
+    {
+        TextureImage& entry = textureImages_[texture];
+        entry.texture_ = texture;
+        entry.image_ = image;
+    }
+    else
+        textureImages_.Erase(texture);
+}
+
+bool UISoftwareRenderer::Render(Image* dest, int width, int height, const PODVector<UIBatch>& batches, const PODVector<float>& vertexData,
+    const Color& clearColor)
+{
+    if (!dest || width <= 0 || height <= 0)
+        return false;
+    if (!dest->SetSize(width, height, 4))
+        return false;
+
+    pixels_ = dest->GetData();
+    width_ = width;
+    numSkippedBatches_ = 0;
+
+    unsigned clear = clearColor.ToUInt();
+    for (int y = 0; y < height; ++y)
+        FillSpanReplace(pixels_ + y * width * 4, width, clear);
+
+    // Textures can change between renders, for example font textures when glyphs are rendered, so read them again each time
+    textureData_.Clear();
+
+    IntRect screen(0, 0, width, height);
+
+    // UIBatch moves the vertices to match the Direct3D9 pixel centers. Move them back, so that the pixels covered are the same
+    // as on OpenGL and the image does not depend on the graphics API the engine was built for
+    float adjustX = UIBatch::posAdjust.x_;
+    float adjustY = UIBatch::posAdjust.y_;
+    float triangle[3 * UI_VERTEX_SIZE];
+
+    for (unsigned i = 0; i < batches.Size(); ++i)
+    {
+        const UIBatch& batch = batches[i];
+        if (batch.vertexStart_ == batch.vertexEnd_)
+            continue;
+
+        IntRect clip(Max(batch.scissor_.left_, screen.left_), Max(batch.scissor_.top_, screen.top_),
+            Min(batch.scissor_.right_, screen.right_), Min(batch.scissor_.bottom_, screen.bottom_));
+        if (clip.left_ >= clip.right_ || clip.top_ >= clip.bottom_)
+            continue;
+
+        const TextureData* texture = 0;
+        if (batch.texture_)
+        {
+            texture = GetTextureData(batch.texture_);
+            if (!texture)
+            {
+                ++numSkippedBatches_;
+                continue;
+            }
+        }
+
+        // Textured batches without alpha blending use the alpha mask shader, which discards pixels below half alpha
+        bool alphaMask = texture && batch.blendMode_ != BLEND_ALPHA && batch.blendMode_ != BLEND_ADDALPHA &&
+            batch.blendMode_ != BLEND_PREMULALPHA;
+        bool canFillRects = !texture && (batch.blendMode_ == BLEND_REPLACE || batch.blendMode_ == BLEND_ALPHA);
+
+        const float* vertices = &vertexData[batch.vertexStart_];
+        unsigned numVertices = (batch.vertexEnd_ - batch.vertexStart_) / UI_VERTEX_SIZE;
+        unsigned j = 0;
+
+        while (j + 3 <= numVertices)
+        {
+            const float* v = vertices + j * UI_VERTEX_SIZE;
+
+            // Most UI quads are solid axis-aligned rectangles, which are filled a span at a time
+            if (canFillRects && j + 6 <= numVertices && IsSolidRect(v))
+            {
+                unsigned color;
+                memcpy(&color, &v[3], sizeof color);
+                FillRect(v[0] + adjustX, v[1] + adjustY, v[UI_VERTEX_SIZE + 0] + adjustX, v[2 * UI_VERTEX_SIZE + 1] + adjustY, color,
+                    batch.blendMode_, clip);
+                j += 6;
+            }
+            else
+            {
+                memcpy(triangle, v, sizeof triangle);
+                for (unsigned k = 0; k < 3; ++k)
+                {
+                    triangle[k * UI_VERTEX_SIZE] += adjustX;
+                    triangle[k * UI_VERTEX_SIZE + 1] += adjustY;
+                }
+                RasterizeTriangle(triangle, triangle + UI_VERTEX_SIZE, triangle + 2 * UI_VERTEX_SIZE, texture, batch.blendMode_, alphaMask,
+                    clip);
+                j += 3;
+            }
+        }
+    }
+
+    if (numSkippedBatches_)
+        LOGWARNING("Skipped " + String(numSkippedBatches_) + " UI batches without texture data in software rendering");
+
+    pixels_ = 0;
+    return true;
+}
+
+const UISoftwareRenderer::TextureData* UISoftwareRenderer::GetTextureData(Texture* texture)
+{
+    HashMap<Texture*, TextureData>::ConstIterator i = textureData_.Find(texture);
+    if (i != textureData_.End())
+        return i->second_.width_ ? &i->second_ : 0;
+
+    TextureData& data = textureData_[texture];
+    data.width_ = 0;
+    data.height_ = 0;
+
+    // Single channel textures in the alpha format are font textures, which are sampled as white with alpha
+    bool alphaTexture = texture->GetFormat() == Graphics::GetAlphaFormat();
+
+    int width;
+    int height;
+    unsigned components;
+    PODVector<unsigned char> src;
+    bool swapRedBlue = false;
+
+    HashMap<Texture*, TextureImage>::ConstIterator j = textureImages_.Find(texture);
+    if (j != textureImages_.End() && j->second_.texture_.Get() == texture && j->second_.image_)
+    {
+        Image* image = j->second_.image_;
+        if (image->IsCompressed())
+        {
+            LOGWARNING("Compressed images are not supported in software UI rendering");
+            return 0;
+        }
+
+        width = image->GetWidth();
+        height = image->GetHeight();
+        components = image->GetComponents();
+        src.Resize(width * height * components);
+        if (!src.Empty())
+            memcpy(&src[0], image->GetData(), src.Size());
+    }
+    else if (texture->GetType() == Texture2D::GetTypeStatic())
+    {
+        width = texture->GetWidth();
+        height = texture->GetHeight();
+        unsigned rowSize = texture->GetRowDataSize(width);
+        if (!width || !height || rowSize % width)
+            return 0;
+
+        components = rowSize / width;
+        src.Resize(rowSize * height);
+        if (!static_cast<Texture2D*>(texture)->GetData(0, &src[0]))
+            return 0;
+
+        #ifndef USE_OPENGL
+        // Direct3D9 stores 4-component textures as BGRA
+        swapRedBlue = components == 4;
+        #endif
+    }
+    else
+        return 0;
+
+    if (!width || !height || !components || components > 4)
+        return 0;
+
+    data.data_.Resize(width * height * 4);
+    const unsigned char* in = &src[0];
+    unsigned char* out = &data.data_[0];
+
+    for (int k = 0; k < width * height; ++k)
+    {
+        switch (components)
+        {
+        case 1:
+            if (alphaTexture)
+            {
+                out[0] = out[1] = out[2] = 255;
+                out[3] = in[0];
+            }
+            else
+            {
+                out[0] = out[1] = out[2] = in[0];
+                out[3] = 255;
+            }
+            break;
+
+        case 2:
+            out[0] = out[1] = out[2] = in[0];
+            out[3] = in[1];
+            break;
+
+        case 3:
+            out[0] = in[0];
+            out[1] = in[1];
+            out[2] = in[2];
+            out[3] = 255;
+            break;
+
+        default:
+            out[0] = in[swapRedBlue ? 2 : 0];
+            out[1] = in[1];
+            out[2] = in[swapRedBlue ? 0 : 2];
+            out[3] = in[3];
+            break;
+        }
+
+        in += components;
+        out += 4;
+    }
+
+    data.width_ = width;
+    data.height_ = height;
+    return &data;
+}
+
+void UISoftwareRenderer::RasterizeTriangle(const float* v0, const float* v1, const float* v2, const TextureData* texture,
+    BlendMode blendMode, bool alphaMask, const IntRect& clip)
+{
+    float area = EdgeFunction(v0, v1, v2[0], v2[1]);
+    if (area == 0.0f)
+        return;
+    // The graphics device culls nothing that the UI generates, so accept both windings
+    if (area < 0.0f)
+    {
+        Swap(v1, v2);
+        area = -area;
+    }
+
+    int left = Max((int)floorf(Min(Min(v0[0], v1[0]), v2[0])), clip.left_);
+    int top = Max((int)floorf(Min(Min(v0[1], v1[1]), v2[1])), clip.top_);
+    int right = Min((int)ceilf(Max(Max(v0[0], v1[0]), v2[0])), clip.right_);
+    int bottom = Min((int)ceilf(Max(Max(v0[1], v1[1]), v2[1])), clip.bottom_);
+    if (left >= right || top >= bottom)
+        return;
+
+    bool topLeft0 = IsTopLeftEdge(v1, v2);
+    bool topLeft1 = IsTopLeftEdge(v2, v0);
+    bool topLeft2 = IsTopLeftEdge(v0, v1);
+
+    // Vertex colors as floats in the 0-1 range
+    float colors[3][4];
+    const float* vertices[3] = { v0, v1, v2 };
+    for (unsigned k = 0; k < 3; ++k)
+    {
+        unsigned char bytes[4];
+        memcpy(bytes, &vertices[k][3], sizeof bytes);
+        for (unsigned c = 0; c < 4; ++c)
+            colors[k][c] = bytes[c] * (1.0f / 255.0f);
+    }
+
+    float invArea = 1.0f / area;
+
+    for (int y = top; y < bottom; ++y)
+    {
+        float py = (float)y + 0.5f;
+        unsigned char* row = pixels_ + (y * width_) * 4;
+
+        for (int x = left; x < right; ++x)
+        {
+            float px = (float)x + 0.5f;
+            float w0 = EdgeFunction(v1, v2, px, py);
+            float w1 = EdgeFunction(v2, v0, px, py);
+            float w2 = EdgeFunction(v0, v1, px, py);
+            if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                continue;
+            if ((w0 == 0.0f && !topLeft0) || (w1 == 0.0f && !topLeft1) || (w2 == 0.0f && !topLeft2))
+                continue;
+
+            w0 *= invArea;
+            w1 *= invArea;
+            w2 *= invArea;
+
+            float src[4];
+            for (unsigned c = 0; c < 4; ++c)
+                src[c] = colors[0][c] * w0 + colors[1][c] * w1 + colors[2][c] * w2;
+
+            if (texture)
+            {
+                // Nearest sampling with clamping. UI quads map texels to pixels one to one, so this matches bilinear filtering there
+                float u = v0[4] * w0 + v1[4] * w1 + v2[4] * w2;
+                float v = v0[5] * w0 + v1[5] * w1 + v2[5] * w2;
+                int tx = Clamp((int)floorf(u * texture->width_), 0, texture->width_ - 1);
+                int ty = Clamp((int)floorf(v * texture->height_), 0, texture->height_ - 1);
+                const unsigned char* texel = &texture->data_[(ty * texture->width_ + tx) * 4];
+                for (unsigned c = 0; c < 4; ++c)
+                    src[c] *= texel[c] * (1.0f / 255.0f);
+
+                if (alphaMask && src[3] < 0.5f)
+                    continue;
+            }
+
+            BlendPixel(row + x * 4, src, blendMode);
+        }
+    }
+}
+
+void UISoftwareRenderer::FillRect(float left, float top, float right, float bottom, unsigned color, BlendMode blendMode, const IntRect& clip)
+{
+    // Cover the pixels whose centers are inside, with the left and top edges inclusive as in triangle rasterization
+    int x0 = Max((int)ceilf(left - 0.5f), clip.left_);
+    int y0 = Max((int)ceilf(top - 0.5f), clip.top_);
+    int x1 = Min((int)ceilf(right - 0.5f), clip.right_);
+    int y1 = Min((int)ceilf(bottom - 0.5f), clip.bottom_);
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    for (int y = y0; y < y1; ++y)
+    {
+        unsigned char* dest = pixels_ + (y * width_ + x0) * 4;
+        if (blendMode == BLEND_REPLACE)
+            FillSpanReplace(dest, x1 - x0, color);
+        else
+            FillSpanAlpha(dest, x1 - x0, color);
+    }
+}
+
+}
@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "HashMap.h"
+#include "UIBatch.h"
+
+namespace Urho3D
+{
+
+class Image;
+class Texture;
+
+/// CPU rasterizer for %UI batches. Produces the same image as the graphics device, apart from texture filtering, without needing one.
+class URHO3D_API UISoftwareRenderer : public RefCounted
+{
+public:
+    /// Construct.
+    UISoftwareRenderer();
+    /// Destruct.
+    virtual ~UISoftwareRenderer();
+
+    /// Set pixel data for a texture. Used instead of reading the texture back from the graphics device, which is not possible without one. A null image removes.
+    void SetTextureImage(Texture* texture, Image* image);
+    /// Rasterize batches into an image, which is resized to the given size and cleared first. Return true if successful.
+    bool Render(Image* dest, int width, int height, const PODVector<UIBatch>& batches, const PODVector<float>& vertexData, const Color& clearColor);
+
+    /// Return number of batches skipped in the last render because their texture had no pixel data.
+    unsigned GetNumSkippedBatches() const { return numSkippedBatches_; }
+
+private:
+    /// Texture pixels converted to RGBA.
+    struct TextureData
+    {
+        /// Pixel data.
+        PODVector<unsigned char> data_;
+        /// Width.
+        int width_;
+        /// Height.
+        int height_;
+    };
+
+    /// Pixel data set for a texture.
+    struct TextureImage
+    {
+        /// Texture. Used to detect a destroyed texture whose address has been reused.
+        WeakPtr<Texture> texture_;
+        /// Image.
+        SharedPtr<Image> image_;
+    };
+
+    /// Return the pixel data of a texture, or null if not available.
+    const TextureData* GetTextureData(Texture* texture);
+    /// Rasterize a triangle.
+    void RasterizeTriangle(const float* v0, const float* v1, const float* v2, const TextureData* texture, BlendMode blendMode, bool alphaMask, const IntRect& clip);
+    /// Fill an axis-aligned rectangle with a solid color.
+    void FillRect(float left, float top, float right, float bottom, unsigned color, BlendMode blendMode, const IntRect& clip);
+
+    /// Pixel data set for textures.
+    HashMap<Texture*, TextureImage> textureImages_;
+    /// Pixel data of the textures used by the current render.
+    HashMap<Texture*, TextureData> textureData_;
+    /// Destination pixels.
+    unsigned char* pixels_;
+    /// Destination width.
+    int width_;
+    /// Number of batches skipped in the last render.
+    unsigned numSkippedBatches_;
+};
+
+}
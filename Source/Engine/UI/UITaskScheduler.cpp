@@ -0,0 +1,153 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Precompiled.h"
+#include "MathDefs.h"
+#include "Profiler.h"
+#include "Timer.h"
+#include "UITaskScheduler.h"
+
+#include "DebugNew.h"
+
+namespace Urho3D
+{
+
+const float DEFAULT_TASK_BUDGET = 2.0f;
+
+/// Remove a task from a task list. Return true if found.
+static bool RemoveTaskFrom(Vector<Pair<int, SharedPtr<UITask> > >& tasks, UITask* task)
+{
+    for (unsigned i = 0; i < tasks.Size(); ++i)
+    {
+        if (tasks[i].second_.Get() == task)
+        {
+            tasks.Erase(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+UITaskScheduler::UITaskScheduler() :
+    runningTask_(0),
+    runningTaskRemoved_(false),
+    budget_(DEFAULT_TASK_BUDGET),
+    budgetOverruns_(0)
+{
+}
+
+UITaskScheduler::~UITaskScheduler()
+{
+}
+
+void UITaskScheduler::AddTask(UITask* task, int priority)
+{
+    if (!task)
+        return;
+
+    // Insert before the tasks of the same priority, so that those scheduled earlier run first
+    unsigned index = 0;
+    while (index < tasks_.Size() && tasks_[index].first_ < priority)
+        ++index;
+    tasks_.Insert(index, MakePair(priority, SharedPtr<UITask>(task)));
+}
+
+void UITaskScheduler::RemoveTask(UITask* task)
+{
+    if (task && task == runningTask_)
+    {
+        runningTaskRemoved_ = true;
+        return;
+    }
+
+    if (!RemoveTaskFrom(tasks_, task) && !RemoveTaskFrom(runningTasks_, task))
+        RemoveTaskFrom(unfinishedTasks_, task);
+}
+
+void UITaskScheduler::RemoveAllTasks()
+{
+    tasks_.Clear();
+    runningTasks_.Clear();
+    unfinishedTasks_.Clear();
+    if (runningTask_)
+        runningTaskRemoved_ = true;
+}
+
+void UITaskScheduler::SetBudget(float budget)
+{
+    budget_ = Max(budget, 0.0f);
+}
+
+unsigned UITaskScheduler::Run()
+{
+    if (tasks_.Empty())
+        return 0;
+
+    PROFILE(RunUITasks);
+
+    HiresTimer taskTimer;
+    long long budget = (long long)(budget_ * 1000.0f);
+
+    // Run each task at most once per call, so that a task that keeps returning false can neither stall the frame nor starve the
+    // tasks behind it. Tasks scheduled while running wait for the next call
+    runningTasks_.Swap(tasks_);
+    unsigned numRun = 0;
+
+    // Always run at least one step, so that the backlog makes progress even when the frame is already expensive
+    while (!runningTasks_.Empty() && (!numRun || !budget || taskTimer.GetUSec(false) < budget))
+    {
+        Pair<int, SharedPtr<UITask> > entry = runningTasks_.Back();
+        runningTasks_.Pop();
+
+        runningTask_ = entry.second_;
+        runningTaskRemoved_ = false;
+        ++numRun;
+        bool finished = entry.second_->Run();
+        runningTask_ = 0;
+
+        if (!finished && !runningTaskRemoved_)
+            unfinishedTasks_.Push(entry);
+    }
+
+    // Tasks that did not get to run keep their place ahead of those scheduled later
+    for (unsigned i = 0; i < runningTasks_.Size(); ++i)
+    {
+        int priority = runningTasks_[i].first_;
+        unsigned index = 0;
+        while (index < tasks_.Size() && tasks_[index].first_ <= priority)
+            ++index;
+        tasks_.Insert(index, runningTasks_[i]);
+    }
+    runningTasks_.Clear();
+
+    // Unfinished tasks go behind the other tasks of the same priority
+    for (unsigned i = 0; i < unfinishedTasks_.Size(); ++i)
+        AddTask(unfinishedTasks_[i].second_, unfinishedTasks_[i].first_);
+    unfinishedTasks_.Clear();
+
+    if (budget && taskTimer.GetUSec(false) > budget)
+        ++budgetOverruns_;
+
+    return numRun;
+}
+
+}
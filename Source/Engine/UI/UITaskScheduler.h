@@ -0,0 +1,83 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "Ptr.h"
+#include "Vector.h"
+
+namespace Urho3D
+{
+
+/// Deferrable %UI work, run by the %UI subsystem within a per-frame time budget.
+class URHO3D_API UITask : public RefCounted
+{
+public:
+    /// Run a step of the work. Return true when finished, or false to be run again.
+    virtual bool Run() = 0;
+};
+
+/// Prioritized %UI tasks run within a per-frame time budget.
+class URHO3D_API UITaskScheduler : public RefCounted
+{
+public:
+    /// Construct.
+    UITaskScheduler();
+    /// Destruct.
+    virtual ~UITaskScheduler();
+
+    /// Schedule a task. Higher priority tasks run first, tasks of the same priority in order of scheduling.
+    void AddTask(UITask* task, int priority = 0);
+    /// Remove a scheduled task.
+    void RemoveTask(UITask* task);
+    /// Remove all scheduled tasks.
+    void RemoveAllTasks();
+    /// Set time budget in milliseconds. Each task runs at most once per Run() call. Zero runs every task once without a time limit.
+    void SetBudget(float budget);
+    /// Run scheduled tasks within the budget. Return number of task steps run.
+    unsigned Run();
+
+    /// Return time budget in milliseconds.
+    float GetBudget() const { return budget_; }
+    /// Return number of scheduled tasks.
+    unsigned GetNumTasks() const { return tasks_.Size(); }
+    /// Return number of Run() calls that exceeded the budget.
+    unsigned GetBudgetOverruns() const { return budgetOverruns_; }
+
+private:
+    /// Scheduled tasks and their priorities, sorted by ascending priority. The next task to run is last.
+    Vector<Pair<int, SharedPtr<UITask> > > tasks_;
+    /// Tasks waiting to run during Run().
+    Vector<Pair<int, SharedPtr<UITask> > > runningTasks_;
+    /// Tasks that ran during Run() without finishing.
+    Vector<Pair<int, SharedPtr<UITask> > > unfinishedTasks_;
+    /// Task being run.
+    UITask* runningTask_;
+    /// Whether the task being run was removed.
+    bool runningTaskRemoved_;
+    /// Time budget in milliseconds.
+    float budget_;
+    /// Number of Run() calls that exceeded the budget.
+    unsigned budgetOverruns_;
+};
+
+}
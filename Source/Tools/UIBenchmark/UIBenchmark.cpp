@@ -0,0 +1,416 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "BorderImage.h"
+#include "Context.h"
+#include "File.h"
+#include "FileSystem.h"
+#include "Font.h"
+#include "InputEvents.h"
+#include "ProcessUtils.h"
+#include "Random.h"
+#include "ResourceCache.h"
+#include "StringUtils.h"
+#include "Text.h"
+#include "Timer.h"
+#include "UI.h"
+#include "UIQuads.h"
+#include "VectorBuffer.h"
+#include "XMLFile.h"
+
+#include <cstdlib>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include "DebugNew.h"
+
+using namespace Urho3D;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+/// Headless root size.
+static const IntVector2 ROOT_SIZE(1920, 1080);
+/// Depth of each element chain in the deep trees.
+static const unsigned DEEP_CHAIN_LENGTH = 32;
+/// Cursor positions queried per GetElementAt() measurement.
+static const unsigned NUM_ELEMENT_QUERIES = 1000;
+/// Focus moves per traversal measurement.
+static const unsigned NUM_FOCUS_MOVES = 100;
+/// Glyph quads per quad writing measurement.
+static const unsigned NUM_GLYPH_QUADS = 10000;
+
+/// Timing of one operation in one scenario.
+struct Measurement
+{
+    /// Construct.
+    Measurement(const String& scenario, const String& operation, unsigned elements) :
+        scenario_(scenario),
+        operation_(operation),
+        elements_(elements),
+        iterations_(0),
+        total_(0),
+        min_(0),
+        max_(0)
+    {
+    }
+
+    /// Add the time of one iteration in microseconds.
+    void Add(long long usec)
+    {
+        if (!iterations_ || usec < min_)
+            min_ = usec;
+        if (!iterations_ || usec > max_)
+            max_ = usec;
+        total_ += usec;
+        ++iterations_;
+    }
+
+    /// Scenario name.
+    String scenario_;
+    /// Operation name.
+    String operation_;
+    /// Number of elements in the tree, or of glyph quads.
+    unsigned elements_;
+    /// Number of iterations.
+    unsigned iterations_;
+    /// Total time in microseconds.
+    long long total_;
+    /// Fastest iteration in microseconds.
+    long long min_;
+    /// Slowest iteration in microseconds.
+    long long max_;
+};
+
+static SharedPtr<Context> context_;
+static SharedPtr<Font> font_;
+static Vector<Measurement> results_;
+static unsigned iterations_ = 10;
+
+/// Create a leaf element of a scenario. Text-heavy trees use text elements, others sprite-like border images.
+static UIElement* CreateLeaf(UIElement* parent, bool text, unsigned index)
+{
+    UIElement* element;
+    if (text)
+    {
+        Text* textElement = new Text(context_);
+        if (font_)
+            textElement->SetFont(font_, 12);
+        // Mix ASCII and CJK, so that both the static and the on demand glyphs are exercised
+        textElement->SetText("Item " + String(index) + " \xe7\x89\xa9\xe5\x93\x81" + String(index % 97));
+        element = textElement;
+    }
+    else
+    {
+        BorderImage* image = new BorderImage(context_);
+        image->SetColor(Color((index % 7) / 7.0f, (index % 11) / 11.0f, (index % 13) / 13.0f));
+        element = image;
+    }
+
+    element->SetFocusMode(FM_FOCUSABLE);
+    element->SetPosition((index * 37) % (ROOT_SIZE.x_ - 64), (index * 19) % (ROOT_SIZE.y_ - 16));
+    element->SetSize(64, 16);
+    parent->AddChild(element);
+    return element;
+}
+
+/// Build a tree of the given number of elements under a top level container. A flat tree has every element under the
+/// container, a deep tree has chains of nested elements.
+static SharedPtr<UIElement> BuildTree(unsigned numElements, bool deep, bool text)
+{
+    SharedPtr<UIElement> container(new UIElement(context_));
+    container->SetSize(ROOT_SIZE);
+
+    UIElement* parent = container;
+    for (unsigned i = 0; i < numElements; ++i)
+    {
+        if (deep && i % DEEP_CHAIN_LENGTH == 0)
+            parent = container;
+
+        UIElement* element = CreateLeaf(parent, text, i);
+        if (deep)
+        {
+            // Keep nested elements overlapping their parent, so that position queries descend the chain
+            element->SetPosition(1, 1);
+            element->SetSize(parent == container ? IntVector2(640, 360) : parent->GetSize() - IntVector2(2, 2));
+            parent = element;
+        }
+    }
+
+    return container;
+}
+
+/// Measure the UI hot paths on one tree.
+static void RunScenario(const String& scenario, unsigned numElements, bool deep, bool text)
+{
+    UI* ui = context_->GetSubsystem<UI>();
+    UIElement* root = ui->GetRoot();
+
+    Measurement build(scenario, "BuildTree", numElements);
+    HiresTimer timer;
+    SharedPtr<UIElement> tree = BuildTree(numElements, deep, text);
+    root->AddChild(tree);
+    build.Add(timer.GetUSec(true));
+    results_.Push(build);
+
+    Measurement update(scenario, "Update", numElements);
+    Measurement renderUpdate(scenario, "RenderUpdate", numElements);
+    Measurement elementAt(scenario, "GetElementAt", numElements);
+    Measurement focus(scenario, "FocusTraversal", numElements);
+    Measurement loadLayout(scenario, "LoadLayout", numElements);
+
+    // The first frame renders the glyphs and lays out the text, so keep it out of the results
+    ui->Update(1.0f / 60.0f);
+    ui->RenderUpdate();
+
+    SetRandomSeed(1);
+    for (unsigned i = 0; i < iterations_; ++i)
+    {
+        timer.Reset();
+        ui->Update(1.0f / 60.0f);
+        update.Add(timer.GetUSec(true));
+
+        ui->RenderUpdate();
+        renderUpdate.Add(timer.GetUSec(true));
+
+        for (unsigned j = 0; j < NUM_ELEMENT_QUERIES; ++j)
+            ui->GetElementAt(Rand() % ROOT_SIZE.x_, Rand() % ROOT_SIZE.y_);
+        elementAt.Add(timer.GetUSec(true));
+    }
+
+    // Move the focus with the tab key through the focusable elements of the top level container
+    UIElement* first = tree->GetNumChildren() ? tree->GetChild(0u) : 0;
+    if (first)
+    {
+        ui->SetFocusElement(first);
+        for (unsigned i = 0; i < NUM_FOCUS_MOVES; ++i)
+        {
+            using namespace KeyDown;
+
+            VariantMap eventData;
+            eventData[P_KEY] = KEY_TAB;
+            eventData[P_BUTTONS] = 0;
+            eventData[P_QUALIFIERS] = 0;
+            eventData[P_REPEAT] = false;
+
+            timer.Reset();
+            ui->SendEvent(E_KEYDOWN, eventData);
+            focus.Add(timer.GetUSec(true));
+
+            // Run the frame update between key presses, as an application would
+            ui->Update(0.0f);
+        }
+        ui->SetFocusElement(0);
+    }
+
+    // Save the tree as a layout and load it back
+    SharedPtr<XMLFile> xml(new XMLFile(context_));
+    XMLElement rootElem = xml->CreateRoot("element");
+    tree->SaveXML(rootElem);
+    VectorBuffer layout;
+    xml->Save(layout);
+    tree->Remove();
+
+    for (unsigned i = 0; i < iterations_; ++i)
+    {
+        layout.Seek(0);
+        timer.Reset();
+        SharedPtr<UIElement> loaded = ui->LoadLayout(layout);
+        loadLayout.Add(timer.GetUSec(true));
+        if (!loaded)
+        {
+            PrintLine("Could not load the layout of scenario " + scenario, true);
+            break;
+        }
+    }
+
+    results_.Push(update);
+    results_.Push(renderUpdate);
+    results_.Push(elementAt);
+    if (focus.iterations_)
+        results_.Push(focus);
+    if (loadLayout.iterations_)
+        results_.Push(loadLayout);
+
+    PrintLine("Finished " + scenario + " with " + String(numElements) + " elements", true);
+}
+
+/// Measure writing glyph quads per glyph through UIBatch::AddQuad() against the scalar and vectorized bulk writers.
+static void RunQuadScenario()
+{
+    SharedPtr<UIElement> element(new UIElement(context_));
+    PODVector<float> vertexData;
+    PODVector<float> rects;
+    PODVector<float> uvRects;
+    PODVector<IntVector2> positions;
+
+    SetRandomSeed(1);
+    for (unsigned i = 0; i < NUM_GLYPH_QUADS; ++i)
+    {
+        IntVector2 position(Rand() % ROOT_SIZE.x_, Rand() % ROOT_SIZE.y_);
+        positions.Push(position);
+        rects.Push((float)position.x_);
+        rects.Push((float)position.y_);
+        rects.Push((float)(position.x_ + 8));
+        rects.Push((float)(position.y_ + 12));
+        uvRects.Push(0.0f);
+        uvRects.Push(0.0f);
+        uvRects.Push(1.0f);
+        uvRects.Push(1.0f);
+    }
+
+    Measurement addQuad("glyph_quads", "AddQuad", NUM_GLYPH_QUADS);
+    Measurement scalar("glyph_quads", "WriteQuadsScalar", NUM_GLYPH_QUADS);
+    Measurement vectorized("glyph_quads", "WriteQuads", NUM_GLYPH_QUADS);
+    HiresTimer timer;
+    unsigned color = Color::WHITE.ToUInt();
+
+    // Keep the vertex buffer allocated between iterations, as the UI keeps its own
+    vertexData.Reserve(NUM_GLYPH_QUADS * 6 * UI_VERTEX_SIZE);
+
+    for (unsigned i = 0; i < iterations_; ++i)
+    {
+        vertexData.Clear();
+        timer.Reset();
+        UIBatch batch(element, BLEND_ALPHA, IntRect::ZERO, 0, &vertexData);
+        batch.SetColor(Color::WHITE);
+        for (unsigned j = 0; j < NUM_GLYPH_QUADS; ++j)
+            batch.AddQuad(positions[j].x_, positions[j].y_, 8, 12, 0, 0);
+        addQuad.Add(timer.GetUSec(true));
+
+        vertexData.Resize(NUM_GLYPH_QUADS * 6 * UI_VERTEX_SIZE);
+        timer.Reset();
+        WriteQuadsScalar(&vertexData[0], &rects[0], &uvRects[0], NUM_GLYPH_QUADS, color);
+        scalar.Add(timer.GetUSec(true));
+
+        WriteQuads(&vertexData[0], &rects[0], &uvRects[0], NUM_GLYPH_QUADS, color);
+        vectorized.Add(timer.GetUSec(true));
+    }
+
+    results_.Push(addQuad);
+    results_.Push(scalar);
+    results_.Push(vectorized);
+
+    PrintLine("Finished glyph_quads with " + String(NUM_GLYPH_QUADS) + " quads", true);
+}
+
+/// Return the results as JSON.
+static String WriteJSON()
+{
+    String json = "{\n  \"benchmark\": \"UIBenchmark\",\n  \"iterations\": " + String(iterations_) + ",\n  \"results\": [\n";
+    for (unsigned i = 0; i < results_.Size(); ++i)
+    {
+        const Measurement& m = results_[i];
+        double mean = m.iterations_ ? (double)m.total_ / m.iterations_ : 0.0;
+        json += "    { \"scenario\": \"" + m.scenario_ + "\", \"operation\": \"" + m.operation_ + "\", \"elements\": " +
+            String(m.elements_) + ", \"iterations\": " + String(m.iterations_) + ", \"meanUs\": " + String(mean) + ", \"minUs\": " +
+            String((double)m.min_) + ", \"maxUs\": " + String((double)m.max_) + " }";
+        json += i + 1 < results_.Size() ? ",\n" : "\n";
+    }
+    json += "  ]\n}\n";
+    return json;
+}
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+    
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+    
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    String resourceDir;
+    String outputName;
+    unsigned maxElements = 100000;
+
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        if (arguments[i] == "-data" && i + 1 < arguments.Size())
+            resourceDir = arguments[++i];
+        else if (arguments[i] == "-o" && i + 1 < arguments.Size())
+            outputName = arguments[++i];
+        else if (arguments[i] == "-max" && i + 1 < arguments.Size())
+            maxElements = ToUInt(arguments[++i]);
+        else if (arguments[i] == "-iterations" && i + 1 < arguments.Size())
+            iterations_ = Max(ToUInt(arguments[++i]), 1U);
+        else
+        {
+            ErrorExit(
+                "Usage: UIBenchmark [-data <resource directory>] [-o <output file>] [-max <elements>] [-iterations <count>]\n\n"
+                "Measures the UI hot paths on synthetic trees of 1k to 100k elements without a window, then glyph quad writing per glyph\n"
+                "and in bulk, and writes the results as JSON to the output file or the standard output. Text-heavy trees are laid out\n"
+                "with Fonts/Anonymous Pro.ttf from the resource directory if given."
+            );
+        }
+    }
+
+    context_ = new Context();
+    context_->RegisterSubsystem(new FileSystem(context_));
+    context_->RegisterSubsystem(new ResourceCache(context_));
+    context_->RegisterSubsystem(new UI(context_));
+
+    // Set the headless size first, as it enables loading fonts without a graphics device
+    UI* ui = context_->GetSubsystem<UI>();
+    ui->SetHeadlessSize(ROOT_SIZE);
+
+    if (!resourceDir.Empty())
+    {
+        ResourceCache* cache = context_->GetSubsystem<ResourceCache>();
+        cache->AddResourceDir(resourceDir);
+        font_ = cache->GetResource<Font>("Fonts/Anonymous Pro.ttf");
+    }
+
+    for (unsigned numElements = 1000; numElements <= maxElements; numElements *= 10)
+    {
+        RunScenario("flat_sprite", numElements, false, false);
+        RunScenario("deep_sprite", numElements, true, false);
+        RunScenario("flat_text", numElements, false, true);
+        RunScenario("deep_text", numElements, true, true);
+    }
+
+    RunQuadScenario();
+
+    String json = WriteJSON();
+    if (outputName.Empty())
+        PrintLine(json);
+    else
+    {
+        File output(context_, outputName, FILE_WRITE);
+        if (!output.IsOpen())
+            ErrorExit("Could not open output file " + outputName);
+        output.Write(json.CString(), json.Length());
+    }
+
+    font_.Reset();
+    context_.Reset();
+}
@@ -0,0 +1,658 @@
+//
+// Copyright (c) 2008-2013 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "BorderImage.h"
+#include "Context.h"
+#include "File.h"
+#include "FileSystem.h"
+#include "GapBuffer.h"
+#include "Font.h"
+#include "Graphics.h"
+#include "Image.h"
+#include "LineBreak.h"
+#include "ProcessUtils.h"
+#include "Random.h"
+#include "ResourceCache.h"
+#include "Text.h"
+#include "TextDecode.h"
+#include "TextEditBuffer.h"
+#include "Texture2D.h"
+#include "UI.h"
+#include "UIQuads.h"
+#include "UISoftwareRenderer.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include "DebugNew.h"
+
+using namespace Urho3D;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+static SharedPtr<Context> context_;
+static unsigned numFailures_ = 0;
+
+/// Report a check result.
+static void Check(bool condition, const String& description)
+{
+    if (!condition)
+    {
+        PrintLine("FAILED: " + description);
+        ++numFailures_;
+    }
+}
+
+/// Append a quad in the vertex order and with the position adjustment of UIBatch::AddQuad().
+static void AddQuad(PODVector<float>& vertexData, float left, float top, float right, float bottom, float u0, float v0, float u1, float v1,
+    const Color& color)
+{
+    left -= UIBatch::posAdjust.x_;
+    right -= UIBatch::posAdjust.x_;
+    top -= UIBatch::posAdjust.y_;
+    bottom -= UIBatch::posAdjust.y_;
+
+    const float positions[6][4] =
+    {
+        { left, top, u0, v0 },
+        { right, top, u1, v0 },
+        { left, bottom, u0, v1 },
+        { right, top, u1, v0 },
+        { right, bottom, u1, v1 },
+        { left, bottom, u0, v1 }
+    };
+
+    unsigned colorValue = color.ToUInt();
+    for (unsigned i = 0; i < 6; ++i)
+    {
+        float vertex[UI_VERTEX_SIZE];
+        vertex[0] = positions[i][0];
+        vertex[1] = positions[i][1];
+        vertex[2] = 0.0f;
+        memcpy(&vertex[3], &colorValue, sizeof colorValue);
+        vertex[4] = positions[i][2];
+        vertex[5] = positions[i][3];
+        for (unsigned j = 0; j < UI_VERTEX_SIZE; ++j)
+            vertexData.Push(vertex[j]);
+    }
+}
+
+/// Append a batch covering the vertices added since the previous batch.
+static void AddBatch(PODVector<UIBatch>& batches, const PODVector<float>& vertexData, BlendMode blendMode, const IntRect& scissor,
+    Texture* texture)
+{
+    UIBatch batch;
+    batch.blendMode_ = blendMode;
+    batch.scissor_ = scissor;
+    batch.texture_ = texture;
+    batch.vertexStart_ = batches.Empty() ? 0 : batches.Back().vertexEnd_;
+    batch.vertexEnd_ = vertexData.Size();
+    batches.Push(batch);
+}
+
+/// Return whether a pixel of an RGBA image is within one step of a color in each channel.
+static bool PixelEquals(Image* image, int x, int y, unsigned r, unsigned g, unsigned b, unsigned a)
+{
+    const unsigned char* pixel = image->GetData() + (y * image->GetWidth() + x) * 4;
+    const unsigned expected[4] = { r, g, b, a };
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (Abs((int)pixel[i] - (int)expected[i]) > 1)
+            return false;
+    }
+    return true;
+}
+
+/// Check solid rectangles, which go through the span fill, against the expected pixels of each blend mode and the scissor.
+static void TestSolidRects()
+{
+    PODVector<UIBatch> batches;
+    PODVector<float> vertexData;
+
+    AddQuad(vertexData, 2.0f, 2.0f, 10.0f, 10.0f, 0.0f, 0.0f, 0.0f, 0.0f, Color(1.0f, 0.0f, 0.0f, 1.0f));
+    AddBatch(batches, vertexData, BLEND_REPLACE, IntRect(0, 0, 16, 16), 0);
+    Color blue(0.0f, 0.0f, 1.0f, 0.5f);
+    AddQuad(vertexData, 6.0f, 6.0f, 14.0f, 14.0f, 0.0f, 0.0f, 0.0f, 0.0f, blue);
+    AddBatch(batches, vertexData, BLEND_ALPHA, IntRect(0, 0, 16, 16), 0);
+    AddQuad(vertexData, 0.0f, 12.0f, 16.0f, 16.0f, 0.0f, 0.0f, 0.0f, 0.0f, Color(0.0f, 1.0f, 0.0f, 1.0f));
+    AddBatch(batches, vertexData, BLEND_REPLACE, IntRect(0, 0, 4, 16), 0);
+
+    SharedPtr<UISoftwareRenderer> renderer(new UISoftwareRenderer());
+    SharedPtr<Image> image(new Image(context_));
+    Check(renderer->Render(image, 16, 16, batches, vertexData, Color(0.0f, 0.0f, 0.0f, 1.0f)), "Solid rectangles render");
+
+    // Blue at half alpha over red and over the black clear color
+    unsigned half = blue.ToUInt() >> 24;
+    unsigned blendedRed = (255 * (255 - half) + 127) / 255;
+    for (int y = 0; y < 16; ++y)
+    {
+        for (int x = 0; x < 16; ++x)
+        {
+            bool inRed = x >= 2 && x < 10 && y >= 2 && y < 10;
+            bool inBlue = x >= 6 && x < 14 && y >= 6 && y < 14;
+            bool inGreen = x < 4 && y >= 12;
+            bool ok;
+            if (inGreen)
+                ok = PixelEquals(image, x, y, 0, 255, 0, 255);
+            else if (inBlue)
+                ok = PixelEquals(image, x, y, inRed ? blendedRed : 0, 0, half, 255);
+            else if (inRed)
+                ok = PixelEquals(image, x, y, 255, 0, 0, 255);
+            else
+                ok = PixelEquals(image, x, y, 0, 0, 0, 255);
+            Check(ok, "Solid rectangle pixel " + String(x) + "," + String(y));
+        }
+    }
+}
+
+/// Check a textured quad, which goes through triangle rasterization, against the texels it maps one to one.
+static void TestTexturedQuad()
+{
+    SharedPtr<Image> textureImage(new Image(context_));
+    textureImage->SetSize(2, 2, 4);
+    const unsigned char texels[16] =
+    {
+        255, 0, 0, 255,  0, 255, 0, 255,
+        0, 0, 255, 255,  255, 255, 255, 255
+    };
+    textureImage->SetData(texels);
+
+    // Without a graphics device the texture only records its size and format, and the renderer reads the image instead
+    SharedPtr<Texture2D> texture(new Texture2D(context_));
+    texture->SetSize(2, 2, Graphics::GetRGBAFormat());
+
+    PODVector<UIBatch> batches;
+    PODVector<float> vertexData;
+    AddQuad(vertexData, 4.0f, 4.0f, 8.0f, 8.0f, 0.0f, 0.0f, 1.0f, 1.0f, Color::WHITE);
+    AddBatch(batches, vertexData, BLEND_REPLACE, IntRect(0, 0, 12, 12), texture);
+
+    SharedPtr<UISoftwareRenderer> renderer(new UISoftwareRenderer());
+    renderer->SetTextureImage(texture, textureImage);
+    SharedPtr<Image> image(new Image(context_));
+    Check(renderer->Render(image, 12, 12, batches, vertexData, Color(0.0f, 0.0f, 0.0f, 0.0f)), "Textured quad renders");
+    Check(renderer->GetNumSkippedBatches() == 0, "Textured quad finds its texture data");
+
+    for (int y = 0; y < 12; ++y)
+    {
+        for (int x = 0; x < 12; ++x)
+        {
+            bool ok;
+            if (x >= 4 && x < 8 && y >= 4 && y < 8)
+            {
+                const unsigned char* texel = &texels[(((y - 4) / 2) * 2 + (x - 4) / 2) * 4];
+                ok = PixelEquals(image, x, y, texel[0], texel[1], texel[2], texel[3]);
+            }
+            else
+                ok = PixelEquals(image, x, y, 0, 0, 0, 0);
+            Check(ok, "Textured quad pixel " + String(x) + "," + String(y));
+        }
+    }
+}
+
+/// Check that the UI renders to an image without a graphics device, using the headless root size.
+static void TestHeadlessUI()
+{
+    UI* ui = context_->GetSubsystem<UI>();
+    ui->SetHeadlessSize(IntVector2(32, 24));
+
+    SharedPtr<BorderImage> element(new BorderImage(context_));
+    element->SetPosition(4, 4);
+    element->SetSize(8, 8);
+    element->SetColor(Color(1.0f, 1.0f, 0.0f, 1.0f));
+    ui->GetRoot()->AddChild(element);
+
+    SharedPtr<Image> image(new Image(context_));
+    Check(ui->RenderToImage(image, Color(0.0f, 0.0f, 0.0f, 1.0f)), "Headless UI renders to image");
+    Check(image->GetWidth() == 32 && image->GetHeight() == 24, "Headless UI image has the headless root size");
+    if (image->GetWidth() == 32 && image->GetHeight() == 24)
+    {
+        Check(PixelEquals(image, 4, 4, 255, 255, 0, 255) && PixelEquals(image, 11, 11, 255, 255, 0, 255), "Headless UI element covers its rectangle");
+        Check(PixelEquals(image, 3, 4, 0, 0, 0, 255) && PixelEquals(image, 12, 11, 0, 0, 0, 255), "Headless UI element does not cover outside its rectangle");
+    }
+
+    element->Remove();
+}
+
+/// Render text with a font loaded without a graphics device, and compare it to a golden image. A missing golden image is created.
+static void TestHeadlessText(const String& goldenDir)
+{
+    // Fonts load without a graphics device only when the UI renders in software, which the headless size enables
+    UI* ui = context_->GetSubsystem<UI>();
+    ui->SetHeadlessSize(IntVector2(128, 32));
+
+    ResourceCache* cache = context_->GetSubsystem<ResourceCache>();
+    Font* font = cache->GetResource<Font>("Fonts/Anonymous Pro.ttf");
+    Check(font != 0, "Font loads without a graphics device");
+    if (!font)
+        return;
+
+    SharedPtr<Text> text(new Text(context_));
+    text->SetFont(font, 12);
+    text->SetText("Urho3D \xe4\xbd\xa0\xe5\xa5\xbd");
+    text->SetColor(Color::WHITE);
+    text->SetPosition(2, 2);
+    ui->GetRoot()->AddChild(text);
+
+    SharedPtr<Image> image(new Image(context_));
+    Check(ui->RenderToImage(image, Color(0.0f, 0.0f, 0.0f, 1.0f)), "Headless text renders to image");
+    text->Remove();
+
+    unsigned coveredPixels = 0;
+    for (int i = 0; i < image->GetWidth() * image->GetHeight(); ++i)
+    {
+        if (image->GetData()[i * 4])
+            ++coveredPixels;
+    }
+    Check(coveredPixels > 0, "Headless text draws glyphs from the CPU font atlas");
+
+    if (goldenDir.Empty())
+        return;
+
+    String goldenName = AddTrailingSlash(goldenDir) + "HeadlessText.png";
+    if (!context_->GetSubsystem<FileSystem>()->FileExists(goldenName))
+    {
+        image->SavePNG(goldenName);
+        PrintLine("Created golden image " + goldenName);
+        return;
+    }
+
+    File goldenFile(context_, goldenName);
+    SharedPtr<Image> golden(new Image(context_));
+    if (!golden->Load(goldenFile) || golden->GetComponents() != 4)
+    {
+        Check(false, "Golden image " + goldenName + " loads");
+        return;
+    }
+
+    bool matches = golden->GetWidth() == image->GetWidth() && golden->GetHeight() == image->GetHeight() &&
+        !memcmp(golden->GetData(), image->GetData(), image->GetWidth() * image->GetHeight() * 4);
+    Check(matches, "Headless text matches golden image " + goldenName);
+}
+
+/// Check the vectorized quad writer and vertex translation against their scalar paths, and the quads against UIBatch::AddQuad().
+static void TestQuadWriters()
+{
+    // An odd number of quads and vertices, so that the tails of the vectorized loops are exercised
+    const unsigned numQuads = 7;
+    const unsigned numFloats = numQuads * 6 * UI_VERTEX_SIZE;
+
+    SharedPtr<UIElement> element(new UIElement(context_));
+    element->SetPosition(17, 9);
+    PODVector<float> reference;
+    UIBatch batch(element, BLEND_ALPHA, IntRect::ZERO, 0, &reference);
+    batch.SetColor(Color(1.0f, 0.5f, 0.25f, 0.75f));
+    const unsigned color = batch.color_;
+
+    PODVector<float> rects;
+    PODVector<float> uvRects;
+    SetRandomSeed(1);
+    for (unsigned i = 0; i < numQuads; ++i)
+    {
+        int x = Rand() % 100;
+        int y = Rand() % 100;
+        int width = Rand() % 20 + 1;
+        int height = Rand() % 20 + 1;
+        int texX = Rand() % 100;
+        int texY = Rand() % 100;
+        batch.AddQuad(x, y, width, height, texX, texY);
+
+        float left = (float)(x + 17) - UIBatch::posAdjust.x_;
+        float top = (float)(y + 9) - UIBatch::posAdjust.y_;
+        rects.Push(left);
+        rects.Push(top);
+        rects.Push(left + (float)width);
+        rects.Push(top + (float)height);
+        uvRects.Push((float)texX);
+        uvRects.Push((float)texY);
+        uvRects.Push((float)(texX + width));
+        uvRects.Push((float)(texY + height));
+    }
+
+    PODVector<float> vectorized(numFloats);
+    PODVector<float> scalar(numFloats);
+    WriteQuads(&vectorized[0], &rects[0], &uvRects[0], numQuads, color);
+    WriteQuadsScalar(&scalar[0], &rects[0], &uvRects[0], numQuads, color);
+    Check(!memcmp(&vectorized[0], &scalar[0], numFloats * sizeof(float)), "WriteQuads matches the scalar path");
+    Check(reference.Size() == numFloats && !memcmp(&vectorized[0], &reference[0], numFloats * sizeof(float)),
+        "WriteQuads matches UIBatch::AddQuad");
+
+    // The offset is added to the positions only
+    WriteQuads(&vectorized[0], &rects[0], &uvRects[0], numQuads, color, Vector2(3.0f, -5.0f));
+    WriteQuadsScalar(&scalar[0], &rects[0], &uvRects[0], numQuads, color, Vector2(3.0f, -5.0f));
+    Check(!memcmp(&vectorized[0], &scalar[0], numFloats * sizeof(float)), "WriteQuads with an offset matches the scalar path");
+
+    // Translate an odd number of vertices, both to another buffer and in place
+    const unsigned numVertices = numQuads * 6 - 1;
+    const Vector2 offset(-2.0f, 7.0f);
+    TranslateVertices(&vectorized[0], &reference[0], numVertices, offset);
+    TranslateVerticesScalar(&scalar[0], &reference[0], numVertices, offset);
+    Check(!memcmp(&vectorized[0], &scalar[0], numVertices * UI_VERTEX_SIZE * sizeof(float)), "TranslateVertices matches the scalar path");
+    TranslateVertices(&reference[0], &reference[0], numVertices, offset);
+    Check(!memcmp(&reference[0], &scalar[0], numVertices * UI_VERTEX_SIZE * sizeof(float)), "TranslateVertices in place matches the scalar path");
+}
+
+/// Decode UTF-8 text with both decoder paths and check the characters and validity against the expected result.
+static void CheckDecode(const String& description, const String& text, const unsigned* expected, unsigned numExpected, bool expectedValid)
+{
+    PODVector<unsigned> vectorized;
+    PODVector<unsigned> scalar;
+    bool vectorizedValid = DecodeUTF8(text, vectorized);
+    bool scalarValid = DecodeUTF8Scalar(text.CString(), text.Length(), scalar);
+
+    Check(vectorized == scalar && vectorizedValid == scalarValid, "DecodeUTF8 matches the scalar path: " + description);
+    bool matches = vectorized.Size() == numExpected && vectorizedValid == expectedValid;
+    for (unsigned i = 0; matches && i < numExpected; ++i)
+        matches = vectorized[i] == expected[i];
+    Check(matches, "DecodeUTF8 result: " + description);
+}
+
+/// Check the UTF-8 decoder on ASCII runs around the 16-byte vector width and on invalid sequences, and compare the vectorized
+/// path to the scalar path on random text.
+static void TestUTF8Decode()
+{
+    const unsigned R = UTF8_REPLACEMENT_CHAR;
+    PODVector<unsigned> expected;
+
+    CheckDecode("empty", String::EMPTY, 0, 0, true);
+
+    // ASCII runs shorter than, equal to and crossing the vector width, with a multi-byte character straddling each boundary
+    for (unsigned prefix = 0; prefix <= 40; ++prefix)
+    {
+        String text;
+        expected.Clear();
+        for (unsigned i = 0; i < prefix; ++i)
+        {
+            text += (char)('a' + i % 26);
+            expected.Push('a' + i % 26);
+        }
+        text += "\xe4\xbd\xa0";
+        expected.Push(0x4f60);
+        for (unsigned i = 0; i < 17; ++i)
+        {
+            text += 'Z';
+            expected.Push('Z');
+        }
+        CheckDecode("ASCII run of " + String(prefix) + " bytes", text, &expected[0], expected.Size(), true);
+    }
+
+    const unsigned fourByte[] = { 'a', 0x1f600, 0x10ffff, 'b' };
+    CheckDecode("four-byte characters", "a\xf0\x9f\x98\x80\xf4\x8f\xbf\xbf" "b", fourByte, 4, true);
+
+    // A truncated sequence is replaced one byte at a time, whether it is cut off by the end or by another character
+    const unsigned truncatedEnd[] = { 'a', 'b', R, R };
+    CheckDecode("sequence truncated by the end", "ab\xe4\xbd", truncatedEnd, 4, false);
+    const unsigned truncatedMiddle[] = { R, R, 'x', R, 'y' };
+    CheckDecode("sequence truncated by another character", "\xe4\xbdx\xf0y", truncatedMiddle, 5, false);
+    String longTruncated;
+    expected.Clear();
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        longTruncated += 'q';
+        expected.Push('q');
+    }
+    longTruncated += "\xf0\x9f\x98";
+    expected.Push(R);
+    expected.Push(R);
+    expected.Push(R);
+    CheckDecode("sequence truncated after a full vector of ASCII", longTruncated, &expected[0], expected.Size(), false);
+    const unsigned stray[] = { R, 'a' };
+    CheckDecode("stray continuation byte", "\x80" "a", stray, 2, false);
+
+    // Overlong encodings of '/' and of U+07FF, and values above U+10FFFF
+    const unsigned overlong2[] = { R, R };
+    CheckDecode("overlong two-byte encoding", "\xc0\xaf", overlong2, 2, false);
+    const unsigned overlong3[] = { R, R, R };
+    CheckDecode("overlong three-byte encoding", "\xe0\x80\xaf", overlong3, 3, false);
+    CheckDecode("overlong three-byte encoding of U+07FF", "\xe0\x9f\xbf", overlong3, 3, false);
+    const unsigned overlong4[] = { R, R, R, R };
+    CheckDecode("overlong four-byte encoding", "\xf0\x80\x80\xaf", overlong4, 4, false);
+    CheckDecode("value above U+10FFFF", "\xf4\x90\x80\x80", overlong4, 4, false);
+
+    // Encoded UTF-16 surrogates
+    const unsigned surrogate[] = { 'a', R, R, R, R, R, R, 'b' };
+    CheckDecode("high and low surrogates", "a\xed\xa0\x80\xed\xbf\xbf" "b", surrogate, 8, false);
+
+    // Random text, mostly ASCII so that vector-width runs occur, with random high bytes mixed in
+    SetRandomSeed(1);
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+        String text;
+        unsigned length = Rand() % 100;
+        for (unsigned j = 0; j < length; ++j)
+            text += (char)(Rand() % 8 ? 0x20 + Rand() % 0x5f : 0x80 + Rand() % 0x80);
+
+        PODVector<unsigned> vectorized;
+        PODVector<unsigned> scalar;
+        bool vectorizedValid = DecodeUTF8(text, vectorized);
+        bool scalarValid = DecodeUTF8Scalar(text.CString(), text.Length(), scalar);
+        Check(vectorized == scalar && vectorizedValid == scalarValid, "DecodeUTF8 matches the scalar path on random text " + String(i));
+    }
+}
+
+/// Apply random replacements to a gap buffer and compare its contents to a vector edited the same way.
+static void TestGapBuffer()
+{
+    SetRandomSeed(1);
+
+    GapBuffer<unsigned> buffer;
+    PODVector<unsigned> expected;
+    unsigned next = 0;
+
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+        // Mostly small edits, sometimes large enough to grow the gap
+        unsigned position = Rand() % (expected.Size() + 1);
+        unsigned length = Min((unsigned)Rand() % 4, expected.Size() - position);
+        PODVector<unsigned> data;
+        unsigned count = Rand() % 8 ? Rand() % 4 : Rand() % 200;
+        for (unsigned j = 0; j < count; ++j)
+            data.Push(next++);
+
+        buffer.Replace(position, length, data.Buffer(), data.Size());
+        expected.Erase(position, length);
+        expected.Insert(position, data);
+
+        bool same = buffer.Size() == expected.Size();
+        for (unsigned j = 0; j < expected.Size() && same; ++j)
+            same = buffer[j] == expected[j];
+        Check(same, "GapBuffer matches a vector after random replace " + String(i));
+    }
+
+    buffer.Assign(expected.Buffer(), 3);
+    Check(buffer.Size() == 3 && buffer[0] == expected[0] && buffer[2] == expected[2], "GapBuffer assigns contents");
+    buffer.Clear();
+    Check(buffer.Empty(), "GapBuffer clears");
+}
+
+/// Check text editing, cursor and selection handling, and row layout of a text editing buffer without a font, where every
+/// character is one unit wide.
+static void TestTextEditBuffer()
+{
+    TextEditBuffer buffer;
+    buffer.SetText("ab\xe4\xbd\xa0" "c");
+    Check(buffer.GetLength() == 4 && buffer.GetCursorPosition() == 4, "TextEditBuffer decodes set text and moves the cursor to the end");
+
+    buffer.SetCursorPosition(2);
+    buffer.InsertAtCursor("xy");
+    Check(buffer.GetText() == "abxy\xe4\xbd\xa0" "c" && buffer.GetCursorPosition() == 4, "TextEditBuffer inserts at the cursor");
+
+    buffer.SetSelection(1, 3);
+    Check(buffer.GetSelectedText() == "bxy" && buffer.GetCursorPosition() == 4, "TextEditBuffer selects text");
+    buffer.InsertAtCursor("\xe5\xa5\xbd");
+    Check(buffer.GetText() == "a\xe5\xa5\xbd\xe4\xbd\xa0" "c" && buffer.GetCursorPosition() == 2 && !buffer.GetSelectionLength(),
+        "TextEditBuffer replaces the selection");
+
+    buffer.DeleteBackward();
+    Check(buffer.GetText() == "a\xe4\xbd\xa0" "c" && buffer.GetCursorPosition() == 1, "TextEditBuffer deletes backward");
+    buffer.DeleteForward();
+    Check(buffer.GetText() == "ac" && buffer.GetCursorPosition() == 1, "TextEditBuffer deletes forward");
+
+    buffer.Insert(0, "zz");
+    Check(buffer.GetText() == "zzac" && buffer.GetCursorPosition() == 3, "TextEditBuffer moves the cursor past text inserted before it");
+    buffer.Erase(2, 10);
+    Check(buffer.GetText() == "zz" && buffer.GetCursorPosition() == 2, "TextEditBuffer clamps erasing to the end");
+
+    // Ten ideographs allow a break between each, so width 4 wraps them to rows of 4, 4 and 2
+    String ideographs;
+    for (unsigned i = 0; i < 10; ++i)
+        ideographs.AppendUTF8(0x4e00 + i);
+    buffer.SetText(ideographs);
+    buffer.SetMaxWidth(4);
+    Check(buffer.GetNumRows() == 3 && buffer.GetRowStart(1) == 4 && buffer.GetRowStart(2) == 8 && buffer.GetRowWidth(2) == 2,
+        "TextEditBuffer wraps ideographs to the maximum width");
+    Check(buffer.GetCharPosition(5) == IntVector2(1, 1), "TextEditBuffer returns character positions by row and column");
+    Check(buffer.GetIndexAt(IntVector2(2, 1)) == 6, "TextEditBuffer returns the character index at a position");
+    Check(buffer.GetIndex(0, 100) == 3, "TextEditBuffer clamps a column to the row");
+
+    // A newline after a full row stays on that row, and the text after it starts the next row
+    buffer.SetCursorPosition(4);
+    buffer.InsertAtCursor("\n");
+    Check(buffer.GetNumRows() == 3 && buffer.GetRowStart(1) == 5 && buffer.GetRowStart(2) == 9 && buffer.GetCursorRow() == 1 &&
+        !buffer.GetCursorColumn(), "TextEditBuffer breaks the row after a newline");
+}
+
+/// Return a random character for line breaking: mostly letters and CJK ideographs, with spaces, newlines and punctuation that
+/// breaking rules treat specially.
+static unsigned RandomLineBreakCharacter()
+{
+    static const unsigned punctuation[] = { ',', '.', '-', '(', ')', 0x3001, 0x3002, 0x300c, 0x300d, 0xff01 };
+
+    unsigned choice = Rand() % 16;
+    if (choice < 6)
+        return 'a' + Rand() % 26;
+    else if (choice < 11)
+        return 0x4e00 + Rand() % 0x100;
+    else if (choice < 13)
+        return ' ';
+    else if (choice < 14)
+        return '\n';
+    else
+        return punctuation[Rand() % (sizeof punctuation / sizeof punctuation[0])];
+}
+
+/// Apply random edits to a line breaker and compare its rows after each incremental rewrap to a fresh full wrap of the same text.
+static void TestLineBreaker()
+{
+    SetRandomSeed(1);
+
+    PODVector<unsigned> text;
+    PODVector<int> advances;
+    LineBreaker breaker;
+    breaker.SetMaxWidth(80);
+    breaker.SetText(text, advances);
+
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+        // Remove up to a few characters and insert mostly a few, sometimes up to a row's worth
+        unsigned start = text.Size() ? Rand() % (text.Size() + 1) : 0;
+        unsigned length = Min((unsigned)Rand() % 4, text.Size() - start);
+        PODVector<unsigned> insertText;
+        PODVector<int> insertAdvances;
+        unsigned insertLength = Rand() % 3 ? Rand() % 3 : Rand() % 12;
+        for (unsigned j = 0; j < insertLength; ++j)
+        {
+            unsigned c = RandomLineBreakCharacter();
+            insertText.Push(c);
+            insertAdvances.Push(c >= 0x3000 ? 12 : 4 + Rand() % 4);
+        }
+
+        breaker.Replace(start, length, insertText, insertAdvances);
+        text.Erase(start, length);
+        text.Insert(start, insertText);
+        advances.Erase(start, length);
+        advances.Insert(start, insertAdvances);
+
+        // Occasionally also change the width, which rewraps everything
+        if (Rand() % 50 == 0)
+            breaker.SetMaxWidth(Rand() % 4 ? 40 + Rand() % 80 : 0);
+
+        LineBreaker full;
+        full.SetMaxWidth(breaker.GetMaxWidth());
+        full.SetText(text, advances);
+
+        bool sameText = breaker.GetLength() == text.Size();
+        for (unsigned j = 0; j < text.Size() && sameText; ++j)
+            sameText = breaker.GetCharacter(j) == text[j] && breaker.GetAdvance(j) == advances[j];
+        Check(sameText, "LineBreaker keeps the edited text after random edit " + String(i));
+        Check(breaker.GetRowStarts() == full.GetRowStarts() && breaker.GetRowWidths() == full.GetRowWidths(),
+            "LineBreaker incremental rewrap matches a full wrap after random edit " + String(i));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+    
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+    
+    Run(arguments);
+    return numFailures_ ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    if (arguments.Size() > 2)
+    {
+        ErrorExit(
+            "Usage: UITest [resource directory] [golden image directory]\n\n"
+            "Checks the UI without a graphics device. With a resource directory that contains Fonts/Anonymous Pro.ttf, also renders\n"
+            "text and compares it to the golden image in the golden image directory, creating the image if it does not exist."
+        );
+    }
+
+    context_ = new Context();
+    context_->RegisterSubsystem(new FileSystem(context_));
+    context_->RegisterSubsystem(new ResourceCache(context_));
+    context_->RegisterSubsystem(new UI(context_));
+
+    TestQuadWriters();
+    TestUTF8Decode();
+    TestGapBuffer();
+    TestTextEditBuffer();
+    TestLineBreaker();
+    TestSolidRects();
+    TestTexturedQuad();
+    TestHeadlessUI();
+
+    if (arguments.Size() > 0)
+    {
+        context_->GetSubsystem<ResourceCache>()->AddResourceDir(arguments[0]);
+        TestHeadlessText(arguments.Size() > 1 ? arguments[1] : String::EMPTY);
+    }
+
+    if (numFailures_)
+        PrintLine(String(numFailures_) + " UI checks failed");
+    else
+        PrintLine("All UI checks passed");
+
+    context_.Reset();
+}